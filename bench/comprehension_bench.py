@@ -0,0 +1,30 @@
+# CPython baseline for comprehension_bench.cpp: the same comprehensions
+# over the same data.
+import time
+
+COUNT = 1000000
+REPEAT = 20
+
+
+def run(name, build):
+    start = time.perf_counter()
+    for _ in range(REPEAT):
+        size = len(build())
+    elapsed = (time.perf_counter() - start) * 1000 / REPEAT
+    print(f"  {name}: {elapsed:.3f} ms ({size} items)")
+
+
+def taxed(prices: list[float]):
+    cheap = [p for p in prices if p < 500.0]
+    return [c * 1.25 for c in cheap]
+
+
+def main():
+    prices = [((i * 7919) % 100003) * 0.01 for i in range(COUNT)]
+    run("map", lambda: [p * 1.25 for p in prices])
+    run("filter, then map", lambda: taxed(prices))
+    run("dict from range", lambda: {i: i * i for i in range(COUNT)})
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+// Compares PyDict with std::unordered_map on dict-heavy workloads.
+// Build: g++ -O2 -std=c++17 -I../runtime dict_bench.cpp -o dict_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pydict.h"
+
+const int KEYS = 200000;
+const int LOOKUPS = 2000000;
+
+template <class F>
+double timeIt(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <class K, class V>
+bool contains(const PyDict<K, V>& map, const K& key) {
+    return map.contains(key);
+}
+
+template <class K, class V>
+bool contains(const std::unordered_map<K, V>& map, const K& key) {
+    return map.find(key) != map.end();
+}
+
+template <class Map, class Key>
+void run(const std::string& name, const std::vector<Key>& keys, const std::vector<Key>& probes) {
+    Map map;
+    int64_t checksum = 0;
+    double insert = timeIt([&] {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            map[keys[i]] = int64_t(i);
+        }
+    });
+    double lookup = timeIt([&] {
+        for (const auto& key : probes) {
+            checksum += contains(map, key) ? 1 : 0;
+        }
+    });
+    double iterate = timeIt([&] {
+        for (int round = 0; round < 10; ++round) {
+            for (auto [key, value] : map) {
+                checksum += value;
+            }
+        }
+    });
+    std::cout << name << ": insert " << keys.size() / insert / 1e6 << " M/s, lookup "
+              << probes.size() / lookup / 1e6 << " M/s, iterate " << keys.size() * 10 / iterate / 1e6
+              << " M/s (checksum " << checksum << ")\n";
+}
+
+int main() {
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> intKeys(KEYS);
+    std::vector<std::string> strKeys(KEYS);
+    for (int i = 0; i < KEYS; ++i) {
+        intKeys[i] = int64_t(rng() % (KEYS * 4));
+        strKeys[i] = "key_" + std::to_string(intKeys[i]);
+    }
+    std::vector<int64_t> intProbes(LOOKUPS);
+    std::vector<std::string> strProbes(LOOKUPS / 4);
+    for (int i = 0; i < LOOKUPS; ++i) {
+        intProbes[i] = intKeys[rng() % KEYS] + (i & 1);
+    }
+    for (auto& probe : strProbes) {
+        probe = strKeys[rng() % KEYS];
+    }
+
+    run<PyDict<int64_t, int64_t>>("PyDict<int>", intKeys, intProbes);
+    run<std::unordered_map<int64_t, int64_t>>("unordered_map<int>", intKeys, intProbes);
+    run<PyDict<std::string, int64_t>>("PyDict<str>", strKeys, strProbes);
+    run<std::unordered_map<std::string, int64_t>>("unordered_map<str>", strKeys, strProbes);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Echo server and clients on one PyEventLoop over loopback; echo_bench.py
+// runs the same workload on asyncio.
+// Build: g++ -O2 -std=c++20 -I../runtime echo_bench.cpp -o echo_bench
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "pyasync.h"
+
+const int PORT = 18766;
+const int CLIENTS = 100;
+const int ROUNDS = 1000;
+const std::size_t MESSAGE = 64;
+
+PyTask<> handle(int fd) {
+    char buf[4096];
+    for (;;) {
+        std::size_t n = co_await pySockRecv(fd, buf, sizeof(buf));
+        if (n == 0) {
+            break;
+        }
+        co_await pySockSendAll(fd, buf, n);
+    }
+    pyClose(fd);
+}
+
+PyTask<> serve(int listenFd) {
+    for (int accepted = 0; accepted < CLIENTS; ++accepted) {
+        pyCreateTask(handle(co_await pySockAccept(listenFd)));
+    }
+}
+
+PyTask<> client(int& finished) {
+    int fd = co_await pySockConnect("127.0.0.1", PORT);
+    char message[MESSAGE];
+    char reply[MESSAGE];
+    std::fill(message, message + MESSAGE, 'x');
+    for (int round = 0; round < ROUNDS; ++round) {
+        co_await pySockSendAll(fd, message, MESSAGE);
+        for (std::size_t got = 0; got < MESSAGE;) {
+            std::size_t n = co_await pySockRecv(fd, reply + got, MESSAGE - got);
+            if (n == 0) {
+                throw std::runtime_error("ConnectionResetError: server closed the connection");
+            }
+            got += n;
+        }
+    }
+    pyClose(fd);
+    ++finished;
+}
+
+PyTask<> run() {
+    int listenFd = pyListenTcp("127.0.0.1", PORT);
+    pyCreateTask(serve(listenFd));
+    auto start = std::chrono::steady_clock::now();
+    int finished = 0;
+    for (int c = 0; c < CLIENTS; ++c) {
+        pyCreateTask(client(finished));
+    }
+    while (finished < CLIENTS) {
+        co_await pySleep(0.001);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    pyClose(listenFd);
+    std::printf("%d clients x %d round trips: %.1f ms, %.0f round trips/s\n", CLIENTS, ROUNDS,
+                elapsed.count() * 1000, CLIENTS * ROUNDS / elapsed.count());
+}
+
+int main() {
+    pyRun(run());
+    return 0;
+}
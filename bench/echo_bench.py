@@ -0,0 +1,41 @@
+# asyncio baseline for echo_bench.cpp: same server, clients and message size.
+import asyncio
+import time
+
+PORT = 18766
+CLIENTS = 100
+ROUNDS = 1000
+MESSAGE = b"x" * 64
+
+
+async def handle(reader, writer):
+    while True:
+        data = await reader.read(4096)
+        if not data:
+            break
+        writer.write(data)
+        await writer.drain()
+    writer.close()
+
+
+async def client():
+    reader, writer = await asyncio.open_connection("127.0.0.1", PORT)
+    for _ in range(ROUNDS):
+        writer.write(MESSAGE)
+        await writer.drain()
+        await reader.readexactly(len(MESSAGE))
+    writer.close()
+
+
+async def main():
+    server = await asyncio.start_server(handle, "127.0.0.1", PORT, backlog=1024)
+    start = time.perf_counter()
+    await asyncio.gather(*(client() for _ in range(CLIENTS)))
+    elapsed = time.perf_counter() - start
+    server.close()
+    print(f"{CLIENTS} clients x {ROUNDS} round trips: {elapsed * 1000:.1f} ms, "
+          f"{CLIENTS * ROUNDS / elapsed:.0f} round trips/s")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,91 @@
+// Times `for i, (a, b) in enumerate(zip(xs, ys))` through the pyiter.h
+// views against the indexed loop one would write by hand, over
+// std::vector<double> (where the two compile to the same loop) and over
+// unboxed PyLists; also map/filter and reversed chains. iter_bench.py is
+// the CPython baseline.
+// Build: g++ -O2 -std=c++17 -I../runtime iter_bench.cpp -o iter_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "pyiter.h"
+#include "pylist.h"
+
+const int COUNT = 1000000;
+const int REPEAT = 20;
+
+template <class F>
+void run(const char* name, F loop) {
+    auto start = std::chrono::steady_clock::now();
+    double result = 0;
+    for (int r = 0; r < REPEAT; ++r) {
+        result = loop();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() / REPEAT << " ms (" << result << ")\n";
+}
+
+int main() {
+    std::vector<double> xv(COUNT);
+    std::vector<double> yv(COUNT);
+    PyList xs;
+    PyList ys;
+    for (int i = 0; i < COUNT; ++i) {
+        xv[i] = double((int64_t(i) * 7919) % 100003) * 0.5;
+        yv[i] = double(i % 1000) + 0.25;
+        xs.append(xv[i]);
+        ys.append(yv[i]);
+    }
+
+    std::cout << "std::vector<double>\n";
+    run("  indexed loop", [&] {
+        double total = 0;
+        for (std::size_t k = 0; k < xv.size() && k < yv.size(); ++k) {
+            total += xv[k] * yv[k] + double(k);
+        }
+        return total;
+    });
+    run("  enumerate(zip)", [&] {
+        double total = 0;
+        for (auto&& [i, items] : pyEnumerate(pyZip(xv, yv))) {
+            auto&& [a, b] = items;
+            total += a * b + double(i);
+        }
+        return total;
+    });
+
+    std::cout << "PyList (unboxed floats)\n";
+    run("  indexed loop", [&] {
+        PyValue total(0.0);
+        for (int64_t k = 0; k < int64_t(xs.size()) && k < int64_t(ys.size()); ++k) {
+            total = total + (xs[k] * ys[k] + PyValue(k));
+        }
+        return total.asFloat();
+    });
+    run("  enumerate(zip)", [&] {
+        PyValue total(0.0);
+        for (auto&& [i, items] : pyEnumerate(pyZip(xs, ys))) {
+            auto&& [a, b] = items;
+            total = total + (a * b + PyValue(i));
+        }
+        return total.asFloat();
+    });
+    run("  map(filter)", [&] {
+        PyValue total(0.0);
+        auto half = [](const auto& v) { return PyValue(v * PyValue(0.5)); };
+        auto big = [](const auto& v) { return PyValue(PyValue(1000.0) < v); };
+        for (auto&& x : pyMap(half, pyFilter(big, xs))) {
+            total = total + x;
+        }
+        return total.asFloat();
+    });
+    run("  reversed", [&] {
+        PyValue total(0.0);
+        for (auto&& x : pyReversed(xs)) {
+            total = total + x;
+        }
+        return total.asFloat();
+    });
+    return 0;
+}
@@ -0,0 +1,55 @@
+# CPython baseline for iter_bench.cpp: the same loops over the same lists.
+import time
+
+COUNT = 1000000
+REPEAT = 20
+
+
+def run(name, loop):
+    start = time.perf_counter()
+    for _ in range(REPEAT):
+        result = loop()
+    elapsed = (time.perf_counter() - start) * 1000 / REPEAT
+    print(f"  {name}: {elapsed:.3f} ms ({result})")
+
+
+def indexed(xs, ys):
+    total = 0.0
+    for k in range(min(len(xs), len(ys))):
+        total += xs[k] * ys[k] + k
+    return total
+
+
+def enumerate_zip(xs, ys):
+    total = 0.0
+    for i, (a, b) in enumerate(zip(xs, ys)):
+        total += a * b + i
+    return total
+
+
+def map_filter(xs):
+    total = 0.0
+    for x in map(lambda v: v * 0.5, filter(lambda v: v > 1000.0, xs)):
+        total += x
+    return total
+
+
+def reversed_sum(xs):
+    total = 0.0
+    for x in reversed(xs):
+        total += x
+    return total
+
+
+def main():
+    xs = [((i * 7919) % 100003) * 0.5 for i in range(COUNT)]
+    ys = [(i % 1000) + 0.25 for i in range(COUNT)]
+    print("list")
+    run("indexed loop", lambda: indexed(xs, ys))
+    run("enumerate(zip)", lambda: enumerate_zip(xs, ys))
+    run("map(filter)", lambda: map_filter(xs))
+    run("reversed", lambda: reversed_sum(xs))
+
+
+if __name__ == "__main__":
+    main()
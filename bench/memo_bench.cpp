@@ -0,0 +1,77 @@
+// Memoized calls through PyLruCache in the shape the translator emits for
+// @functools.cache and @lru_cache(maxsize=N): a two-argument recursive grid
+// walk (mod a prime, so bigints stay out of it) filling an unbounded table,
+// then a million int and str lookups through a 256-entry LRU over 1024
+// distinct keys, so about a quarter hit and the rest evict. memo_bench.py is
+// the CPython baseline.
+// Build: g++ -O2 -std=c++17 -I../runtime memo_bench.cpp -o memo_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pymemo.h"
+
+const int GRID = 300;
+const int REPEAT = 10;
+const int LOOKUPS = 1000000;
+const int64_t MODULUS = 1000000007;
+
+PyLruCache<PyValue, PyValue, PyValue> pathsCache(-1);
+PyValue paths(PyValue r, PyValue c) {
+    return pathsCache.call([&]() -> PyValue {
+        if (r.asInt() == 0 || c.asInt() == 0) {
+            return PyValue(1);
+        }
+        return (paths(r - PyValue(1), c) + paths(r, c - PyValue(1))) % PyValue(MODULUS);
+    }, r, c);
+}
+
+PyLruCache<PyValue, PyValue> lengthCache(256);
+PyValue length(PyValue key) {
+    return lengthCache.call([&]() -> PyValue { return PyValue(int64_t(key.str().size())); }, key);
+}
+
+template <class F>
+void run(const char* name, F body) {
+    auto start = std::chrono::steady_clock::now();
+    PyValue checksum = body();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() << " ms (" << checksum << ")\n";
+}
+
+int main() {
+    run("grid walk, unbounded", [] {
+        PyValue total;
+        for (int r = 0; r < REPEAT; ++r) {
+            pathsCache.cacheClear();
+            // Rows first keeps the recursion shallow.
+            for (int i = 0; i <= GRID; ++i) {
+                total = paths(PyValue(i), PyValue(GRID));
+            }
+        }
+        return total;
+    });
+    std::mt19937 rng(42);
+    std::vector<PyValue> ints;
+    std::vector<PyValue> strs;
+    for (int i = 0; i < LOOKUPS; ++i) {
+        int64_t k = int64_t(rng() % 1024);
+        ints.push_back(PyValue(k));
+        strs.push_back(PyValue("key" + std::to_string(k)));
+    }
+    for (const auto* keys : {&ints, &strs}) {
+        run(keys == &ints ? "int keys, maxsize=256" : "str keys, maxsize=256", [keys] {
+            lengthCache.cacheClear();
+            int64_t total = 0;
+            for (const PyValue& key : *keys) {
+                total += length(key).asInt();
+            }
+            std::cout << lengthCache.cacheInfo() << "\n";
+            return PyValue(total);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+# CPython baseline for memo_bench.cpp: the same grid walk under
+# functools.cache and the same lookups through lru_cache(maxsize=256).
+import functools
+import random
+import sys
+import time
+
+GRID = 300
+REPEAT = 10
+LOOKUPS = 1000000
+MODULUS = 1000000007
+
+
+@functools.cache
+def paths(r, c):
+    if r == 0 or c == 0:
+        return 1
+    return (paths(r - 1, c) + paths(r, c - 1)) % MODULUS
+
+
+@functools.lru_cache(maxsize=256)
+def length(key):
+    return len(str(key))
+
+
+def run(name, body):
+    start = time.perf_counter()
+    checksum = body()
+    elapsed = (time.perf_counter() - start) * 1000
+    print(f"{name}: {elapsed:.1f} ms ({checksum})")
+
+
+def grid_walk():
+    total = None
+    for _ in range(REPEAT):
+        paths.cache_clear()
+        for i in range(GRID + 1):
+            total = paths(i, GRID)
+    return total
+
+
+def lookups(keys):
+    length.cache_clear()
+    total = 0
+    for key in keys:
+        total += length(key)
+    print(length.cache_info())
+    return total
+
+
+def main():
+    sys.setrecursionlimit(10000)
+    run("grid walk, unbounded", grid_walk)
+    rng = random.Random(42)
+    ints = [rng.randrange(1024) for _ in range(LOOKUPS)]
+    strs = ["key" + str(k) for k in ints]
+    run("int keys, maxsize=256", lambda: lookups(ints))
+    run("str keys, maxsize=256", lambda: lookups(strs))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,51 @@
+// Times sum/min/max/any/all over one million unboxed ints and floats with
+// the pyreduce.h kernels, against the same lists in boxed (generic)
+// storage; reduce_bench.py is the CPython baseline. Build with -mavx2 for
+// the AVX2 kernels, without for the scalar ones.
+// Build: g++ -O2 -std=c++17 -mavx2 -I../runtime reduce_bench.cpp -o reduce_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "pyreduce.h"
+
+const int COUNT = 1000000;
+const int REPEAT = 20;
+
+template <class F>
+void run(const char* name, F reduce) {
+    auto start = std::chrono::steady_clock::now();
+    PyValue result;
+    for (int r = 0; r < REPEAT; ++r) {
+        result = reduce();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() / REPEAT << " ms (" << result << ")\n";
+}
+
+void runAll(const char* kind, const PyList& list) {
+    std::cout << kind << "\n";
+    run("  sum", [&] { return pySum(list); });
+    run("  min", [&] { return pyMin(list); });
+    run("  max", [&] { return pyMax(list); });
+    run("  any", [&] { return pyAny(list); });
+    run("  all", [&] { return pyAll(list); });
+}
+
+int main() {
+    PyList ints;
+    PyList floats;
+    for (int i = 0; i < COUNT; ++i) {
+        ints.append((int64_t(i) * 7919) % 100003 + 1);
+        floats.append(double((int64_t(i) * 7919) % 100003) * 0.5 + 1.0);
+    }
+    PyList boxedInts = ints;
+    boxedInts.generalize();
+    PyList boxedFloats = floats;
+    boxedFloats.generalize();
+    runAll("ints (unboxed)", ints);
+    runAll("ints (boxed)", boxedInts);
+    runAll("floats (unboxed)", floats);
+    runAll("floats (boxed)", boxedFloats);
+    return 0;
+}
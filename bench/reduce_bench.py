@@ -0,0 +1,34 @@
+# CPython baseline for reduce_bench.cpp: the same builtins over the same
+# lists.
+import time
+
+COUNT = 1000000
+REPEAT = 20
+
+
+def run(name, reduce):
+    start = time.perf_counter()
+    for _ in range(REPEAT):
+        result = reduce()
+    elapsed = (time.perf_counter() - start) * 1000 / REPEAT
+    print(f"  {name}: {elapsed:.3f} ms ({result})")
+
+
+def run_all(kind, items):
+    print(kind)
+    run("sum", lambda: sum(items))
+    run("min", lambda: min(items))
+    run("max", lambda: max(items))
+    run("any", lambda: any(items))
+    run("all", lambda: all(items))
+
+
+def main():
+    ints = [(i * 7919) % 100003 + 1 for i in range(COUNT)]
+    floats = [((i * 7919) % 100003) * 0.5 + 1.0 for i in range(COUNT)]
+    run_all("ints", ints)
+    run_all("floats", floats)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+// Compares the runtime memory modes on allocation- and release-heavy loops.
+// Build: g++ -O2 -std=c++17 -I../runtime refcount_bench.cpp -o refcount_bench
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pyvalue.h"
+
+const int ITERATIONS = 2000000;
+const int LIVE_OBJECTS = 100000;
+const int ROUNDS = 50;
+
+double allocHeavy() {
+    auto start = std::chrono::steady_clock::now();
+    int64_t checksum = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        PyValue v(int64_t(1) << 50 | i);
+        checksum += v.asInt() & 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum < 0) {
+        std::cout << checksum;
+    }
+    return elapsed.count();
+}
+
+double releaseHeavy() {
+    std::vector<PyValue> live;
+    live.reserve(LIVE_OBJECTS);
+    for (int i = 0; i < LIVE_OBJECTS; ++i) {
+        live.push_back(PyValue("item" + std::to_string(i)));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        std::vector<PyValue> copy = live;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void report(const std::string& mode) {
+    double alloc = allocHeavy();
+    double release = releaseHeavy();
+    std::cout << mode << ": alloc " << ITERATIONS / alloc / 1e6 << " M objects/s, "
+              << "incref+decref " << double(LIVE_OBJECTS) * ROUNDS / release / 1e6 << " M pairs/s\n";
+}
+
+int main() {
+    // Modes only move forward, so run them in this order.
+    report("refcount");
+    pyEnableThreads();
+    report("atomic refcount");
+    pyUseArena();
+    report("arena");
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Measures PySet membership tests per second across load factors.
+// Build: g++ -O2 -std=c++17 -I../runtime set_bench.cpp -o set_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "pyset.h"
+
+const std::size_t CAPACITY = 1 << 20;
+const int LOOKUPS = 4000000;
+
+template <class Set>
+double lookupsPerSecond(const Set& set, const std::vector<int64_t>& probes, int64_t& hits) {
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t probe : probes) {
+        hits += set.count(probe);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return probes.size() / elapsed.count();
+}
+
+struct PySetAdapter {
+    PySet<int64_t> set;
+    std::size_t count(int64_t key) const { return set.contains(key) ? 1 : 0; }
+};
+
+int main() {
+    std::mt19937_64 rng(7);
+    for (double loadFactor : {0.50, 0.625, 0.75, 0.87}) {
+        std::size_t n = std::size_t(CAPACITY * loadFactor);
+        PySetAdapter pySet;
+        pySet.set.reserve(CAPACITY - CAPACITY / 8);
+        std::unordered_set<int64_t> stdSet;
+        stdSet.reserve(n);
+        std::vector<int64_t> keys(n);
+        for (auto& key : keys) {
+            key = int64_t(rng() >> 1);
+            pySet.set.insert(key);
+            stdSet.insert(key);
+        }
+        // Half the probes hit, half miss.
+        std::vector<int64_t> probes(LOOKUPS);
+        for (int i = 0; i < LOOKUPS; ++i) {
+            probes[i] = (i & 1) ? keys[rng() % n] : -int64_t(rng() >> 2) - 1;
+        }
+        int64_t hits = 0;
+        double pyRate = lookupsPerSecond(pySet, probes, hits);
+        double stdRate = lookupsPerSecond(stdSet, probes, hits);
+        std::cout << "load " << pySet.set.loadFactor() << ": PySet " << pyRate / 1e6 << " M lookups/s, "
+                  << "unordered_set " << stdRate / 1e6 << " M lookups/s (hits " << hits << ")\n";
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Compares a field-wise particle update over an array of structs against the
+// same update over PySoA columns.
+// Build: g++ -O2 -std=c++17 -I../runtime soa_bench.cpp -o soa_bench
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "pysoa.h"
+
+const int COUNT = 1000000;
+const int STEPS = 50;
+
+struct Particle {
+    double x, y, z;
+    double vx, vy, vz;
+    double mass;
+    bool alive;
+};
+
+struct ParticleRef {
+    double& x;
+    double& y;
+    double& z;
+    double& vx;
+    double& vy;
+    double& vz;
+    double& mass;
+    bool& alive;
+};
+
+using ParticleList = PySoA<Particle, ParticleRef, &Particle::x, &Particle::y, &Particle::z, &Particle::vx,
+                           &Particle::vy, &Particle::vz, &Particle::mass, &Particle::alive>;
+
+template <class F>
+double millis(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main() {
+    std::vector<Particle> aos;
+    ParticleList soa;
+    aos.reserve(COUNT);
+    soa.reserve(COUNT);
+    for (int i = 0; i < COUNT; ++i) {
+        Particle p{double(i), 0, 0, 0.5, 0, 0, 1, true};
+        aos.push_back(p);
+        soa.append(p);
+    }
+    const double dt = 0.01;
+
+    double aosMs = millis([&] {
+        for (int step = 0; step < STEPS; ++step) {
+            for (Particle& p : aos) {
+                p.x += p.vx * dt;
+            }
+        }
+    });
+    double proxyMs = millis([&] {
+        for (int step = 0; step < STEPS; ++step) {
+            for (ParticleRef p : soa) {
+                p.x += p.vx * dt;
+            }
+        }
+    });
+    double columnMs = millis([&] {
+        for (int step = 0; step < STEPS; ++step) {
+            double* __restrict x = soa.column<&Particle::x>().data();
+            const double* __restrict vx = soa.column<&Particle::vx>().data();
+            for (int i = 0; i < COUNT; ++i) {
+                x[i] += vx[i] * dt;
+            }
+        }
+    });
+
+    std::cout << "AoS:         " << aosMs / STEPS << " ms/step\n";
+    std::cout << "SoA proxies: " << proxyMs / STEPS << " ms/step\n";
+    std::cout << "SoA columns: " << columnMs / STEPS << " ms/step\n";
+    return 0;
+}
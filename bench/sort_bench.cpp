@@ -0,0 +1,53 @@
+// Times pySort on one million random, presorted, reversed and
+// many-duplicate values: unboxed ints and floats (radix path), the same ints
+// boxed (adaptive merge sort), and std::stable_sort on the boxed values for
+// reference. sort_bench.py is the CPython baseline.
+// Build: g++ -O2 -std=c++17 -I../runtime sort_bench.cpp -o sort_bench
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "pysort.h"
+
+const int COUNT = 1000000;
+
+std::vector<int64_t> makeInput(const std::string& shape) {
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> values(COUNT);
+    for (int i = 0; i < COUNT; ++i) {
+        values[i] = shape == "presorted" ? i : shape == "reversed" ? COUNT - i : shape == "duplicates" ? int64_t(rng() % 16) : int64_t(rng() % 1000000000);
+    }
+    return values;
+}
+
+template <class F>
+void run(const char* name, F sort) {
+    auto start = std::chrono::steady_clock::now();
+    sort();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() << " ms\n";
+}
+
+int main() {
+    for (const char* shape : {"random", "presorted", "reversed", "duplicates"}) {
+        std::vector<int64_t> values = makeInput(shape);
+        std::vector<double> halves;
+        for (int64_t v : values) {
+            halves.push_back(double(v) * 0.5);
+        }
+        PyList ints = PyList::ofInts(values);
+        PyList floats = PyList::ofFloats(halves);
+        PyList boxed = ints;
+        boxed.generalize();
+        std::vector<PyValue> reference = boxed.values();
+        std::cout << shape << "\n";
+        run("ints (radix)", [&] { pySort(ints); });
+        run("floats (radix)", [&] { pySort(floats); });
+        run("boxed (merge)", [&] { pySort(boxed); });
+        run("boxed (std::stable_sort)", [&] { std::stable_sort(reference.begin(), reference.end()); });
+    }
+    return 0;
+}
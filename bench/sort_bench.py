@@ -0,0 +1,36 @@
+# CPython baseline for sort_bench.cpp: list.sort on the same shapes of
+# input.
+import random
+import time
+
+COUNT = 1000000
+
+
+def make_input(shape):
+    rng = random.Random(42)
+    if shape == "presorted":
+        return list(range(COUNT))
+    if shape == "reversed":
+        return [COUNT - i for i in range(COUNT)]
+    if shape == "duplicates":
+        return [rng.randrange(16) for _ in range(COUNT)]
+    return [rng.randrange(1000000000) for _ in range(COUNT)]
+
+
+def run(name, items):
+    start = time.perf_counter()
+    items.sort()
+    elapsed = (time.perf_counter() - start) * 1000
+    print(f"  {name}: {elapsed:.1f} ms")
+
+
+def main():
+    for shape in ("random", "presorted", "reversed", "duplicates"):
+        values = make_input(shape)
+        print(shape)
+        run("ints", list(values))
+        run("floats", [v * 0.5 for v in values])
+
+
+if __name__ == "__main__":
+    main()
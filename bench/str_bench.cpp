@@ -0,0 +1,55 @@
+// Times the PyStr builtins on the same text and operations as str_bench.py,
+// so the two outputs can be compared line by line.
+// Build: g++ -O2 -mavx2 -std=c++17 -I../runtime str_bench.cpp -o str_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pystr.h"
+
+const int REPEAT = 5;
+
+std::string makeText() {
+    const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+    std::string text;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1000000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        text += words[(seed >> 16) % 8];
+        text += (i % 16 == 15) ? "\n" : ",";
+    }
+    text += "needle";
+    return text;
+}
+
+template <class F>
+void report(const std::string& name, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t sink = 0;
+    for (int i = 0; i < REPEAT; ++i) {
+        sink += body();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() / REPEAT << " ms (" << sink / REPEAT << ")\n";
+}
+
+int main() {
+    PyStr text(makeText());
+    std::vector<PyStr> parts = text.split(",");
+    PyStr line("   " + makeText().substr(0, 200) + "   ");
+    report("find", [&] { return std::size_t(text.find("needle")); });
+    report("split", [&] { return text.split(",").size(); });
+    report("split views", [&] { return text.splitViews(",").size(); });
+    report("join", [&] { return PyStr(",").join(parts).size(); });
+    report("replace", [&] { return text.replace("eta", "ETA!").size(); });
+    report("strip x100k", [&] {
+        std::size_t n = 0;
+        for (int i = 0; i < 100000; ++i) {
+            n += line.strip().size();
+        }
+        return n;
+    });
+    return 0;
+}
@@ -0,0 +1,47 @@
+# CPython baseline for str_bench.cpp: same text, same operations, same output.
+import time
+
+REPEAT = 5
+
+
+def make_text():
+    words = ["alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"]
+    out = []
+    seed = 12345
+    for i in range(1000000):
+        seed = (seed * 1103515245 + 12345) & 0xFFFFFFFF
+        out.append(words[(seed >> 16) % 8])
+        out.append("\n" if i % 16 == 15 else ",")
+    out.append("needle")
+    return "".join(out)
+
+
+def report(name, body):
+    start = time.perf_counter()
+    sink = 0
+    for _ in range(REPEAT):
+        sink += body()
+    elapsed = (time.perf_counter() - start) * 1000
+    print(f"{name}: {elapsed / REPEAT} ms ({sink // REPEAT})")
+
+
+def strip_loop(line):
+    n = 0
+    for _ in range(100000):
+        n += len(line.strip())
+    return n
+
+
+def main():
+    text = make_text()
+    parts = text.split(",")
+    line = "   " + text[:200] + "   "
+    report("find", lambda: text.find("needle"))
+    report("split", lambda: len(text.split(",")))
+    report("join", lambda: len(",".join(parts)))
+    report("replace", lambda: len(text.replace("eta", "ETA!")))
+    report("strip x100k", lambda: strip_loop(line))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,49 @@
+// Runs CPU-bound chunks on PyThreadPoolExecutor with 1-8 workers to show
+// scaling across cores; thread_bench.py is the same program on CPython.
+// Build: g++ -O2 -std=c++17 -pthread -I../runtime thread_bench.cpp -o thread_bench
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "pythread.h"
+
+const int64_t LIMIT = 2000000;
+const int64_t CHUNKS = 64;
+
+int64_t countPrimes(int64_t lo, int64_t hi) {
+    int64_t count = 0;
+    for (int64_t n = lo < 2 ? 2 : lo; n < hi; ++n) {
+        bool prime = true;
+        for (int64_t d = 2; d * d <= n; ++d) {
+            if (n % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        count += prime;
+    }
+    return count;
+}
+
+int main() {
+    const int64_t step = LIMIT / CHUNKS;
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    for (std::size_t workers : {1, 2, 4, 8}) {
+        auto start = std::chrono::steady_clock::now();
+        int64_t total = 0;
+        {
+            PyThreadPoolExecutor ex(workers);
+            std::vector<PyFuture<int64_t>> futures;
+            for (int64_t c = 0; c < CHUNKS; ++c) {
+                futures.push_back(ex.submit(countPrimes, c * step, (c + 1) * step));
+            }
+            for (const auto& future : futures) {
+                total += future.result();
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << workers << " workers: " << elapsed.count() << " ms (" << total << " primes)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+# CPython baseline for thread_bench.cpp: the same CPU-bound chunks on a
+# ThreadPoolExecutor, which the GIL keeps on one core.
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+LIMIT = 2000000
+CHUNKS = 64
+
+
+def count_primes(lo, hi):
+    count = 0
+    for n in range(max(lo, 2), hi):
+        d = 2
+        while d * d <= n:
+            if n % d == 0:
+                break
+            d += 1
+        else:
+            count += 1
+    return count
+
+
+def main():
+    step = LIMIT // CHUNKS
+    for workers in (1, 2, 4, 8):
+        start = time.perf_counter()
+        with ThreadPoolExecutor(max_workers=workers) as ex:
+            futures = [ex.submit(count_primes, c * step, (c + 1) * step) for c in range(CHUNKS)]
+            total = sum(f.result() for f in futures)
+        elapsed = (time.perf_counter() - start) * 1000
+        print(f"{workers} workers: {elapsed:.1f} ms ({total} primes)")
+
+
+if __name__ == "__main__":
+    main()
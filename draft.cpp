@@ -821,10 +821,40 @@ int main() {
 //**```cpp
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "runtime/pyhash.h"
+#include "runtime/pythread.h"
+
 enum TokenType {
     KEYWORD, IDENTIFIER, NUMBER, STRING, OPERATOR, WHITESPACE, UNKNOWN
 };
@@ -839,9 +869,16 @@ struct Node {
     std::vector<Node> children;
 };
 
+// The patterns are compiled once and shared; matching against a const
+// std::regex is safe from any thread.
 std::vector<Token> tokenize(const std::string& code) {
+    static const std::regex token_regex(R"((\bdef\b|\bprint\b|\bclass\b|\bfor\b|\basync\b|\w+|[0-9]+|".*?"|\s+|[^\w\s"]+))");
+    static const std::regex keyword_regex(R"(\bdef\b|\bprint\b|\bclass\b|\bfor\b|\basync\b)");
+    static const std::regex identifier_regex(R"(\w+)");
+    static const std::regex number_regex(R"([0-9]+)");
+    static const std::regex string_regex(R"(".*?")");
+    static const std::regex whitespace_regex(R"(\s+)");
     std::vector<Token> tokens;
-    std::regex token_regex(R"((\bdef\b|\bprint\b|\w+|[0-9]+|".*?"|\s+|[^\w\s]+))");
     auto tokens_begin = std::sregex_iterator(code.begin(), code.end(), token_regex);
     auto tokens_end = std::sregex_iterator();
 
@@ -850,15 +887,15 @@ std::vector<Token> tokenize(const std::string& code) {
         std::string token_str = match.str();
         TokenType type;
 
-        if (std::regex_match(token_str, std::regex(R"(\bdef\b|\bprint\b)"))) {
+        if (std::regex_match(token_str, keyword_regex)) {
             type = KEYWORD;
-        } else if (std::regex_match(token_str, std::regex(R"(\w+)"))) {
+        } else if (std::regex_match(token_str, identifier_regex)) {
             type = IDENTIFIER;
-        } else if (std::regex_match(token_str, std::regex(R"([0-9]+)"))) {
+        } else if (std::regex_match(token_str, number_regex)) {
             type = NUMBER;
-        } else if (std::regex_match(token_str, std::regex(R"(".*?")"))) {
+        } else if (std::regex_match(token_str, string_regex)) {
             type = STRING;
-        } else if (std::regex_match(token_str, std::regex(R"(\s+)"))) {
+        } else if (std::regex_match(token_str, whitespace_regex)) {
             type = WHITESPACE;
         } else {
             type = OPERATOR;
@@ -873,15 +910,27 @@ std::vector<Token> tokenize(const std::string& code) {
 Node parse(const std::vector<Token>& tokens) {
     Node root;
     Node current;
+    // A keyword inside brackets, e.g. the for of a comprehension, stays in
+    // its expression.
+    int depth = 0;
     for (const auto& token : tokens) {
-        if (token.type == KEYWORD) {
+        if (token.type == KEYWORD && depth <= 0) {
             if (current.value.empty()) {
+                // Statements before the first keyword get a node of their own
+                // rather than joining its header.
+                if (!current.children.empty()) {
+                    root.children.push_back(current);
+                    current.children.clear();
+                }
                 current.value = token.value;
             } else {
                 root.children.push_back(current);
                 current = Node{token.value, {}};
             }
         } else {
+            for (char c : token.type == STRING ? std::string() : token.value) {
+                depth += (c == '(' || c == '[' || c == '{') - (c == ')' || c == ']' || c == '}');
+            }
             current.children.push_back(Node{token.value, {}});
         }
     }
@@ -894,7 +943,12 @@ Node parse(const std::vector<Token>& tokens) {
 bool checkSemantics(const Node& node) {
     for (const auto& child : node.children) {
         if (child.value == "print") {
-            if (child.children.size() == 0 || child.children[0].value[0] != '"') {
+            // The argument follows the call's opening parenthesis.
+            std::size_t arg = 0;
+            while (arg < child.children.size() && child.children[arg].value.find_first_not_of(" \t(") == std::string::npos) {
+                ++arg;
+            }
+            if (arg == child.children.size() || child.children[arg].value[0] != '"') {
                 std::cerr << "Error: 'print' requires a string argument" << std::endl;
                 return false;
             }
@@ -903,126 +957,3337 @@ bool checkSemantics(const Node& node) {
     return true;
 }
 
-std::string generateCode(const Node& node) {
-    std::string code;
-    for (const auto& child : node.children) {
-        if (child.value == "def") {
-            code += "void " + child.children[0].value + "() {\n";
-        } else if (child.value == "print") {
-            code += "std::cout << ";
-            for (const auto& grandChild : child.children) {
-                code += grandChild.value;
+std::string runtimeIncludes() {
+    return "#include \"runtime/pyvalue.h\"\n"
+           "#include \"runtime/pydict.h\"\n"
+           "#include \"runtime/pyset.h\"\n"
+           "#include \"runtime/pystr.h\"\n"
+           "#include \"runtime/pylist.h\"\n"
+           "#include \"runtime/pytuple.h\"\n"
+           "#include \"runtime/pysoa.h\"\n"
+           "#include \"runtime/pygenerator.h\"\n"
+           "#include \"runtime/pyasync.h\"\n"
+           "#include \"runtime/pythread.h\"\n"
+           "#include \"runtime/pyparallel.h\"\n"
+           "#include \"runtime/pyreduce.h\"\n"
+           "#include \"runtime/pysort.h\"\n"
+           "#include \"runtime/pymemo.h\"\n"
+           "#include \"runtime/pyiter.h\"\n";
+}
+
+bool isName(const std::string& value) {
+    static const std::regex kName(R"(\w+)");
+    return std::regex_match(value, kName);
+}
+
+bool isWhitespace(const std::string& value) {
+    static const std::regex kWhitespace(R"(\s+)");
+    return std::regex_match(value, kWhitespace);
+}
+
+// Index of the next token after i that is not whitespace.
+std::size_t nextToken(const std::vector<Node>& tokens, std::size_t i) {
+    do {
+        ++i;
+    } while (i < tokens.size() && isWhitespace(tokens[i].value));
+    return i;
+}
+
+std::string emitDynamicValue(const std::string& expr) {
+    return "PyValue(" + expr + ")";
+}
+
+bool isIntLiteral(const std::string& value) {
+    static const std::regex kDigits(R"([0-9]+)");
+    return std::regex_match(value, kDigits);
+}
+
+bool fitsInt64(const std::string& digits) {
+    static const std::string kInt64Max = "9223372036854775807";
+    return digits.size() < kInt64Max.size() || (digits.size() == kInt64Max.size() && digits <= kInt64Max);
+}
+
+// No range analysis yet, so every int literal becomes a PyValue, which
+// promotes to PyInt on overflow. Literals past int64 are parsed at runtime.
+std::string emitIntLiteral(const std::string& digits) {
+    if (digits.size() < 10) {
+        return emitDynamicValue(digits);
+    }
+    if (fitsInt64(digits)) {
+        return emitDynamicValue("INT64_C(" + digits + ")");
+    }
+    return emitDynamicValue("PyInt::fromString(\"" + digits + "\")");
+}
+
+// Literals are interned once per call site, so repeated evaluation reuses
+// one PyStr and equal literals compare by pointer.
+std::string emitStrLiteral(const std::string& literal) {
+    return "PY_LITERAL(" + literal + ")";
+}
+
+std::string translateExpr(const std::vector<Node>& tokens);
+std::string emitComprehension(const std::vector<Node>& tokens, std::size_t open, std::size_t& close);
+std::string soaListType(const std::string& value);
+
+// A literal of int literals starts in unboxed int64 storage, and one of
+// structs stored as structure-of-arrays in their columns. Anything else is
+// built from PyValues and PyList picks its storage from what it holds.
+std::string emitListLiteral(const std::vector<std::vector<Node>>& elements) {
+    bool allInts = !elements.empty();
+    std::string ints;
+    std::string values;
+    std::string soa;
+    for (const auto& element : elements) {
+        std::vector<std::string> significant;
+        for (const auto& token : element) {
+            if (!isWhitespace(token.value)) {
+                significant.push_back(token.value);
             }
-            code += " << std::endl;\n";
-        } else if (child.value == ":") {
-            code += " {\n";
-        } else {
-            code += child.value;
         }
+        allInts = allInts && significant.size() == 1 && isIntLiteral(significant[0]) && fitsInt64(significant[0]);
+        ints += (ints.empty() ? "" : ", ") + (significant.empty() ? "" : significant[0]);
+        std::string value = translateExpr(element);
+        value.erase(0, value.find_first_not_of(" \t"));
+        soa = values.empty() || soa == soaListType(value) ? soaListType(value) : "";
+        values += (values.empty() ? "" : ", ") + value;
     }
-    code += "}\n";
-    return code;
+    if (allInts) {
+        return "PyList::ofInts({" + ints + "})";
+    }
+    if (!soa.empty()) {
+        return soa + "{" + values + "}";
+    }
+    return "PyList{" + values + "}";
 }
 
-void printTokens(const std::vector<Token>& tokens) {
-    for (const auto& token : tokens) {
-        std::cout << "Token(" << token.value << ", Type: " << token.type << ")" << std::endl;
+bool isStringToken(const std::string& value) {
+    return !value.empty() && value[0] == '"';
+}
+
+// Finds the bracket closing the one that ends tokens[open]. inner gets the
+// tokens in between, including the part of the closing token before the
+// bracket, and rest what follows the bracket in that token. Returns the
+// closing token's index, or tokens.size() if it is unterminated.
+std::size_t bracketClose(const std::vector<Node>& tokens, std::size_t open, std::vector<Node>& inner, std::string& rest) {
+    int depth = 1;
+    for (std::size_t i = open + 1; i < tokens.size(); ++i) {
+        const std::string& value = tokens[i].value;
+        for (std::size_t c = 0; c < value.size() && !isStringToken(value); ++c) {
+            depth += (value[c] == '(' || value[c] == '[' || value[c] == '{') - (value[c] == ')' || value[c] == ']' || value[c] == '}');
+            if (depth == 0) {
+                if (c > 0) {
+                    inner.push_back(Node{value.substr(0, c), {}});
+                }
+                rest = value.substr(c + 1);
+                return i;
+            }
+        }
+        inner.push_back(tokens[i]);
     }
+    return tokens.size();
 }
 
-void printTree(const Node& node, int depth = 0) {
-    std::cout << std::string(depth, ' ') << node.value << std::endl;
-    for (const auto& child : node.children) {
-        printTree(child, depth + 2);
+// Splits tokens on their top-level commas, including commas glued to other
+// punctuation ("],", "),").
+std::vector<std::vector<Node>> splitTopLevel(const std::vector<Node>& tokens) {
+    std::vector<std::vector<Node>> parts(1);
+    int depth = 0;
+    for (const auto& token : tokens) {
+        if (isStringToken(token.value)) {
+            parts.back().push_back(token);
+            continue;
+        }
+        std::string kept;
+        for (char c : token.value) {
+            depth += (c == '(' || c == '[' || c == '{') - (c == ')' || c == ']' || c == '}');
+            if (c == ',' && depth == 0) {
+                if (!kept.empty()) {
+                    parts.back().push_back(Node{kept, {}});
+                }
+                kept.clear();
+                parts.emplace_back();
+            } else {
+                kept += c;
+            }
+        }
+        if (!kept.empty()) {
+            parts.back().push_back(Node{kept, {}});
+        }
     }
+    return parts;
 }
 
-int main() {
-    std::string filename;
-    std::ifstream file;
-    std::string code;
-    std::vector<Token> tokens;
-    Node syntaxTree;
-    bool exit = false;
+// Splits the list literal opened by tokens[open] into its elements, which
+// may be literals themselves. Returns the index of the closing token, or
+// tokens.size() if it is unterminated.
+std::size_t collectListElements(const std::vector<Node>& tokens, std::size_t open,
+                                std::vector<std::vector<Node>>& elements) {
+    std::vector<Node> inner;
+    std::string rest;
+    std::size_t close = bracketClose(tokens, open, inner, rest);
+    for (auto& element : splitTopLevel(inner)) {
+        if (std::any_of(element.begin(), element.end(), [](const Node& token) { return !isWhitespace(token.value); })) {
+            elements.push_back(std::move(element));
+        }
+    }
+    return close;
+}
 
-    while (!exit) {
-        std::cout << "Menu:\n";
-        std::cout << "1. Load Python file\n";
-        std::cout << "2. Tokenize\n";
-        std::cout << "3. Parse\n";
-        std::cout << "4. Check Semantics\n";
-        std::cout << "5. Generate C++ Code\n";
-        std::cout << "6. Exit\n";
-        std::cout << "Choose an option: ";
-        int option;
-        std::cin >> option;
+std::string emitSetType(const std::string& elementType) {
+    return "PySet<" + elementType + ">";
+}
 
-        switch (option) {
-            case 1:
-                std::cout << "Enter filename: ";
-                std::cin >> filename;
-                file.open(filename);
-                if (file.is_open()) {
-                    code.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                    file.close();
-                    std::cout << "File loaded.\n";
-                } else {
-                    std::cerr << "Failed to open file.\n";
+// A set display, {a, b}: the brace that ends tokens[open] and what follows
+// up to its match, with no top-level colon (that is a dict). close is set
+// to the token holding the closing brace. Returns "" for anything else.
+std::string emitSetLiteral(const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    std::vector<Node> inner;
+    std::string rest;
+    close = bracketClose(tokens, open, inner, rest);
+    std::string items;
+    for (const auto& element : splitTopLevel(inner)) {
+        int depth = 0;
+        bool significant = false;
+        for (const auto& token : element) {
+            for (char c : isStringToken(token.value) ? std::string() : token.value) {
+                depth += (c == '(' || c == '[' || c == '{') - (c == ')' || c == ']' || c == '}');
+                if (c == ':' && depth == 0) {
+                    return "";
                 }
-                break;
+            }
+            significant = significant || !isWhitespace(token.value);
+        }
+        if (significant) {
+            items += (items.empty() ? "" : ", ") + translateExpr(element);
+        }
+    }
+    if (close == tokens.size() || items.empty()) {
+        return "";
+    }
+    return emitSetType("PyValue") + "{" + items + "}" + rest;
+}
 
-            case 2:
-                if (!code.empty()) {
-                    tokens = tokenize(code);
-                    printTokens(tokens);
-                } else {
-                    std::cerr << "Load a file first.\n";
-                }
-                break;
+// Whether a token glues a bracket to something else: any square bracket,
+// or a brace opening a tuple as in "{(a, b), ...}".
+bool gluesBracket(const std::string& value) {
+    return value.size() > 1 && !isStringToken(value)
+           && (value.find_first_of("[]") != std::string::npos || value.find("{(") != std::string::npos);
+}
 
-            case 3:
-                if (!tokens.empty()) {
-                    syntaxTree = parse(tokens);
-                    printTree(syntaxTree);
-                } else {
-                    std::cerr << "Tokenize the code first.\n";
+// Gives every square bracket outside a string a token of its own, so "([",
+// "[[" and "][" read as one bracket after another. A brace before a tuple
+// is split off too, so the set display is seen before the tuple.
+std::vector<Node> splitBrackets(const std::vector<Node>& tokens) {
+    std::vector<Node> split;
+    for (const auto& token : tokens) {
+        const std::string& value = token.value;
+        if (!gluesBracket(value)) {
+            split.push_back(token);
+            continue;
+        }
+        std::string kept;
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            char c = value[i];
+            if (c == '[' || c == ']' || (c == '{' && i + 1 < value.size() && value[i + 1] == '(')) {
+                if (!kept.empty()) {
+                    split.push_back(Node{kept, {}});
                 }
-                break;
+                split.push_back(Node{std::string(1, c), {}});
+                kept.clear();
+            } else {
+                kept += c;
+            }
+        }
+        if (!kept.empty()) {
+            split.push_back(Node{kept, {}});
+        }
+    }
+    return split;
+}
 
-            case 4:
-                if (!syntaxTree.value.empty()) {
-                    if (checkSemantics(syntaxTree)) {
-                        std::cout << "Semantic check passed.\n";
-                    }
-                } else {
-                    std::cerr << "Parse the code first.\n";
+// A "[" opens a list literal unless it subscripts what it follows: a name,
+// a call, another subscript or a string.
+bool opensListLiteral(const std::vector<Node>& tokens, std::size_t i) {
+    if (tokens[i].value != "[" || i == 0) {
+        return tokens[i].value == "[";
+    }
+    const std::string& before = tokens[i - 1].value;
+    return !isName(before) && before.back() != ')' && before.back() != ']' && !isStringToken(before);
+}
+
+// pyContains is overloaded in the runtime, so the container's C++ type
+// picks the probing strategy. The result is boxed so it prints as a
+// Python bool.
+std::string emitMembership(const std::string& item, const std::string& container) {
+    return "PyValue(pyContains(" + container + ", " + item + "))";
+}
+
+struct StructInfo {
+    std::vector<std::pair<std::string, std::string>> fields;
+    bool soa = false;
+};
+
+// Classes lowered so far, by name, so later annotations can refer to them.
+// Like everything the translator learns about a program, this is per
+// thread, so a batch can translate files in parallel.
+std::map<std::string, StructInfo>& knownStructs() {
+    thread_local std::map<std::string, StructInfo> structs;
+    return structs;
+}
+
+// Lists of a struct whose fields are all float/bool are stored as
+// structure-of-arrays unless the class sets __layout__ = "aos";
+// __layout__ = "soa" opts any other class in. The proxy Ref is what
+// indexing and iteration hand out: one reference per column.
+std::string emitSoA(const std::string& name, const StructInfo& info) {
+    std::string refs;
+    std::string fields;
+    std::string assigns;
+    std::string members;
+    for (std::size_t f = 0; f < info.fields.size(); ++f) {
+        const std::string& field = info.fields[f].first;
+        refs += "    " + info.fields[f].second + "& " + field + ";\n";
+        fields += (f ? ", " : "") + field;
+        assigns += "        " + field + " = value." + field + ";\n";
+        members += ", &" + name + "::" + field;
+    }
+    return "struct " + name + "Ref {\n" + refs +
+           "    operator " + name + "() const { return " + name + "{" + fields + "}; }\n"
+           "    " + name + "Ref& operator=(const " + name + "& value) {\n" + assigns +
+           "        return *this;\n    }\n"
+           "    " + name + "Ref& operator=(const " + name + "Ref& other) { return *this = " + name + "(other); }\n"
+           "    friend std::ostream& operator<<(std::ostream& os, const " + name + "Ref& self) {\n"
+           "        return os << " + name + "(self);\n    }\n"
+           "};\n"
+           "using " + name + "List = PySoA<" + name + ", " + name + "Ref" + members + ">;\n";
+}
+
+// The <Name>List holding value, a constructor call of a struct stored as
+// structure-of-arrays, or "" for anything else.
+std::string soaListType(const std::string& value) {
+    std::size_t brace = value.find('{');
+    auto known = knownStructs().find(value.substr(0, brace));
+    bool whole = brace != std::string::npos && value.back() == '}';
+    return whole && known != knownStructs().end() && known->second.soa ? known->first + "List" : "";
+}
+
+// The struct a <Name>List of type holds, or "" if it is not one.
+std::string soaElement(const std::string& type) {
+    std::string name = type.size() > 4 && type.compare(type.size() - 4, 4, "List") == 0 ? type.substr(0, type.size() - 4) : "";
+    auto known = knownStructs().find(name);
+    return known != knownStructs().end() && known->second.soa ? name : "";
+}
+
+struct CodegenOptions {
+    // Run provably independent range loops of reductions on the thread pool.
+    bool parallelLoops = false;
+    // Trip count below which such loops still run serially.
+    long minParallelTrips = 10000;
+    // Add floats in source order: no split accumulators in loops, and
+    // sum() as a left fold.
+    bool strictFloatOrder = false;
+};
+
+CodegenOptions& codegenOptions() {
+    static CodegenOptions options;
+    return options;
+}
+
+// Names assigned in the function being emitted with their C++ types, and
+// how it returns.
+struct FunctionScope {
+    std::map<std::string, std::string> locals;
+    std::string returnKeyword = "return";
+    std::vector<std::string> params;
+    // How often each name occurs in the function's block.
+    std::map<std::string, int> uses;
+    // List comprehensions assigned to a local whose one other use is the
+    // next statement, held back so that statement can fuse them: the
+    // local's name and its source, oldest first. A later one may read an
+    // earlier one, so they are declared newest first, letting each consumer
+    // fuse its sources before they are built on their own.
+    std::vector<std::pair<std::string, std::string>> deferred;
+    // Typed module globals entered in locals, so reads reach their storage
+    // as a local's would. Assigning one declares a local instead.
+    std::set<std::string> globals;
+};
+
+FunctionScope& currentScope() {
+    thread_local FunctionScope scope;
+    return scope;
+}
+
+// Module-level names assigned a native type, with that type.
+std::map<std::string, std::string>& moduleGlobals() {
+    thread_local std::map<std::string, std::string> globals;
+    return globals;
+}
+
+bool isListLocal(const std::string& name) {
+    auto local = currentScope().locals.find(name);
+    return local != currentScope().locals.end() && local->second == "PyList";
+}
+
+bool isSetLocal(const std::string& name) {
+    auto local = currentScope().locals.find(name);
+    return local != currentScope().locals.end() && local->second.rfind("PySet<", 0) == 0;
+}
+
+// A local with a native type (list, set, dict) rather than PyValue.
+bool isTypedLocal(const std::string& name) {
+    auto local = currentScope().locals.find(name);
+    return local != currentScope().locals.end() && local->second != "PyValue";
+}
+
+// Functions with no side effects: no output, no stores outside their own
+// locals, and calls only to other pure functions.
+const std::set<std::string>& pureBuiltins() {
+    static const std::set<std::string> builtins = {"min", "max", "abs", "len", "sum", "any", "all",
+                                                   "enumerate", "zip", "reversed"};
+    return builtins;
+}
+
+std::set<std::string>& pureFunctions() {
+    thread_local std::set<std::string> functions = pureBuiltins();
+    return functions;
+}
+
+// Functions defined so far; their names are passed as functions, not
+// PyValues (e.g. a thread target).
+std::set<std::string>& knownFunctions() {
+    thread_local std::set<std::string> functions;
+    return functions;
+}
+
+// Functions memoized by functools.cache or lru_cache; each has a global
+// <name>Cache table.
+std::set<std::string>& cachedFunctions() {
+    thread_local std::set<std::string> functions;
+    return functions;
+}
+
+// Whether the program starts threads of its own (threading,
+// concurrent.futures, parallel loops).
+bool& startsThreads() {
+    thread_local bool starts = false;
+    return starts;
+}
+
+// Forgets the previous program, so the next translation on this thread
+// starts as a fresh process would.
+void resetTranslationState() {
+    knownStructs().clear();
+    currentScope() = FunctionScope();
+    pureFunctions() = pureBuiltins();
+    knownFunctions().clear();
+    cachedFunctions().clear();
+    moduleGlobals().clear();
+    startsThreads() = false;
+}
+
+// Field annotations map to fixed-size members; anything the translator does
+// not know stays a PyValue.
+std::string emitFieldType(const std::string& annotation) {
+    if (annotation == "int") {
+        return "PyInt";
+    }
+    if (annotation == "float") {
+        return "double";
+    }
+    if (annotation == "bool") {
+        return "bool";
+    }
+    if (annotation == "str") {
+        return "PyStr";
+    }
+    if (annotation.rfind("list[", 0) == 0 && annotation.back() == ']') {
+        auto known = knownStructs().find(annotation.substr(5, annotation.size() - 6));
+        if (known != knownStructs().end()) {
+            return known->second.soa ? known->first + "List" : "std::vector<" + known->first + ">";
+        }
+    }
+    if (annotation == "list" || annotation.rfind("list[", 0) == 0) {
+        return "PyList";
+    }
+    if (annotation.rfind("tuple[", 0) == 0 && annotation.back() == ']') {
+        std::string types;
+        std::string current;
+        int depth = 0;
+        for (char c : annotation.substr(6, annotation.size() - 7) + ",") {
+            depth += (c == '[') - (c == ']');
+            if (c == ',' && depth == 0) {
+                types += (types.empty() ? "" : ", ") + emitFieldType(current);
+                current.clear();
+            } else {
+                current += c;
+            }
+        }
+        return "PyTuple<" + types + ">";
+    }
+    return "PyValue";
+}
+
+std::string emitFieldDefault(const std::string& value) {
+    if (value == "True") {
+        return "true";
+    }
+    if (value == "False") {
+        return "false";
+    }
+    if (value == "None") {
+        return "PyValue()";
+    }
+    return value;
+}
+
+// Splits "name: annotation = value" (tokens after the colon) into its
+// annotation and default.
+void splitAnnotation(const std::vector<std::string>& line, std::string& annotation, std::string& value) {
+    bool inDefault = false;
+    for (std::size_t k = 2; k < line.size(); ++k) {
+        if (line[k] == "=" && !inDefault) {
+            inDefault = true;
+        } else {
+            (inDefault ? value : annotation) += line[k];
+        }
+    }
+}
+
+std::string emitDeclaration(const std::vector<std::string>& line) {
+    std::string annotation;
+    std::string value;
+    splitAnnotation(line, annotation, value);
+    std::string declaration = emitFieldType(annotation) + " " + line[0];
+    return declaration + (value.empty() || value == "[]" ? ";\n" : " = " + emitFieldDefault(value) + ";\n");
+}
+
+// A class whose body declares only annotated fields (a dataclass) or
+// __slots__ becomes a plain struct, so attribute access is a member load
+// at a fixed offset. Methods are not lowered yet. Annotated names after
+// the class body are emitted as declarations.
+std::string emitStruct(const Node& node) {
+    std::vector<std::vector<std::string>> lines(1);
+    std::vector<bool> indented(1, true);
+    for (const auto& token : node.children) {
+        std::size_t newline = token.value.rfind('\n');
+        if (newline != std::string::npos) {
+            lines.emplace_back();
+            indented.push_back(newline + 1 < token.value.size());
+        } else if (!isWhitespace(token.value)) {
+            lines.back().push_back(token.value);
+        }
+    }
+    std::string name = lines[0].empty() ? "" : lines[0][0];
+    StructInfo& info = knownStructs()[name];
+    std::string layout;
+    std::string members;
+    std::vector<std::vector<std::string>> declarations;
+    bool inBody = true;
+    for (std::size_t l = 1; l < lines.size(); ++l) {
+        const std::vector<std::string>& line = lines[l];
+        inBody = inBody && (indented[l] || line.empty());
+        if (line.size() >= 3 && isName(line[0]) && line[1] == ":" && !inBody) {
+            declarations.push_back(line);
+        } else if (line.size() >= 3 && isName(line[0]) && line[1] == ":") {
+            std::string annotation;
+            std::string value;
+            splitAnnotation(line, annotation, value);
+            members += "    " + emitDeclaration(line);
+            info.fields.push_back({line[0], emitFieldType(annotation)});
+        } else if (inBody && line.size() >= 2 && line[0] == "__slots__" && line[1] == "=") {
+            for (std::size_t k = 2; k < line.size(); ++k) {
+                if (std::regex_match(line[k], std::regex(R"(".*?"|'.*?')"))) {
+                    info.fields.push_back({line[k].substr(1, line[k].size() - 2), "PyValue"});
+                    members += "    PyValue " + info.fields.back().first + ";\n";
                 }
-                break;
+            }
+        } else if (inBody && line.size() == 3 && line[0] == "__layout__" && line[1] == "=") {
+            layout = line[2].substr(1, line[2].size() - 2);
+        }
+    }
+    std::string repr = "    friend std::ostream& operator<<(std::ostream& os, const " + name + "& self) {\n"
+                       "        os << \"" + name + "(\";\n";
+    std::string left;
+    std::string right;
+    bool allScalar = !info.fields.empty();
+    for (std::size_t f = 0; f < info.fields.size(); ++f) {
+        const std::string& field = info.fields[f].first;
+        repr += "        os << \"" + std::string(f ? ", " : "") + field + "=\";\n"
+                "        pyRepr(os, self." + field + ");\n";
+        left += (f ? ", a." : "a.") + field;
+        right += (f ? ", b." : "b.") + field;
+        allScalar = allScalar && (info.fields[f].second == "double" || info.fields[f].second == "bool");
+    }
+    repr += "        return os << \")\";\n    }\n";
+    std::string equals = "    friend bool operator==(const " + name + "& a, const " + name + "& b) {\n"
+                         "        return std::tie(" + left + ") == std::tie(" + right + ");\n    }\n";
+    info.soa = layout == "soa" || (layout != "aos" && allScalar);
+    std::string code = "struct " + name + " {\n" + members + repr + equals + "};\n";
+    if (info.soa) {
+        code += emitSoA(name, info);
+    }
+    for (const auto& line : declarations) {
+        code += emitDeclaration(line);
+    }
+    return code;
+}
 
-            case 5:
-                if (!syntaxTree.value.empty()) {
-                    std::string cppCode = generateCode(syntaxTree);
-                    std::cout << "Generated C++ Code:\n" << cppCode << std::endl;
-                } else {
-                    std::cerr << "Parse the code first.\n";
+// Splits a call's argument list on its top-level commas, including commas
+// glued to a closing bracket ("],"), up to the closing parenthesis.
+std::vector<std::vector<Node>> splitArguments(const std::vector<Node>& tokens, std::size_t open) {
+    std::vector<std::vector<Node>> args(1);
+    int depth = 0;
+    for (std::size_t i = open; i < tokens.size(); ++i) {
+        std::string kept;
+        for (char c : tokens[i].value) {
+            int before = depth;
+            depth += (c == '(' || c == '[') - (c == ')' || c == ']');
+            if (c == ',' && depth == 1) {
+                if (!kept.empty()) {
+                    args.back().push_back(Node{kept, {}});
                 }
+                kept.clear();
+                args.emplace_back();
+            } else if (before >= 1 && depth >= 1) {
+                kept += c;
+            }
+            if (before >= 1 && depth == 0) {
                 break;
+            }
+        }
+        if (!kept.empty()) {
+            args.back().push_back(Node{kept, {}});
+        }
+        if (depth == 0) {
+            break;
+        }
+    }
+    return args;
+}
 
-            case 6:
-                exit = true;
-                break;
+// Builtins the runtime implements. min and max of one iterable reduce it,
+// with SIMD kernels for unboxed lists, as do sum, any and all.
+std::string emitBuiltin(const std::string& name, std::size_t argCount) {
+    static const std::map<std::string, std::string> kBuiltins = {
+        {"min", "std::min"},
+        {"max", "std::max"},
+        {"len", "pyLen"},
+        {"sum", "pySum"},
+        {"any", "pyAny"},
+        {"all", "pyAll"},
+        {"enumerate", "pyEnumerate"},
+        {"zip", "pyZip"},
+        {"map", "pyMap"},
+        {"filter", "pyFilter"},
+        {"reversed", "pyReversed"},
+    };
+    if ((name == "min" || name == "max") && argCount == 1) {
+        return name == "min" ? "pyMin" : "pyMax";
+    }
+    auto known = kBuiltins.find(name);
+    return known != kBuiltins.end() ? known->second : name;
+}
 
-            default:
-                std::cerr << "Invalid option.\n";
-                break;
+// Standard library names the runtime implements natively.
+std::string emitModuleCall(const std::string& chain) {
+    static const std::map<std::string, std::string> kModules = {
+        {"asyncio.run", "pyRun"},
+        {"asyncio.sleep", "pySleep"},
+        {"asyncio.create_task", "pyCreateTask"},
+        {"threading.Thread", "PyThread"},
+        {"threading.Lock", "PyLock"},
+        {"concurrent.futures.ThreadPoolExecutor", "PyThreadPoolExecutor"},
+    };
+    auto known = kModules.find(chain);
+    return known != kModules.end() ? known->second : chain;
+}
+
+// What follows the parenthesis closing the call opened at tokens[open],
+// within the token that holds it; close is set to that token.
+std::string callRest(const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    int depth = 0;
+    for (close = open; close < tokens.size(); ++close) {
+        const std::string& value = tokens[close].value;
+        std::size_t c = 0;
+        while (c < value.size() && (depth += (value[c] == '(') - (value[c] == ')')) > 0) {
+            ++c;
+        }
+        if (c < value.size()) {
+            return value.substr(c + 1);
         }
     }
+    return "";
+}
 
-    return 0;
+// Joins a line's tokens back into source text without surrounding spaces.
+std::string lineText(const std::vector<Node>& line) {
+    std::string text;
+    for (const auto& token : line) {
+        text += token.value;
+    }
+    std::size_t first = text.find_first_not_of(" \t\r\n");
+    std::size_t last = text.find_last_not_of(" \t\r\n");
+    return first == std::string::npos ? "" : text.substr(first, last - first + 1);
 }
-```
 
-//**This implementation creates a basic menu-driven application that allows you to:
+std::vector<Node> toNodes(const std::string& text) {
+    std::vector<Node> nodes;
+    for (const auto& token : tokenize(text)) {
+        nodes.push_back(Node{token.value, {}});
+    }
+    return nodes;
+}
+
+std::string emitIndex(const std::vector<Node>& expr) {
+    return "(" + translateExpr(expr) + ").asInt()";
+}
+
+// Fields of these types are stored unboxed, so a constructor argument is
+// unboxed to fit; anything else is passed as it is.
+std::string emitFieldArgument(const std::string& type, const std::string& arg) {
+    static const std::set<std::string> kUnboxed = {"double", "bool", "PyInt", "PyStr"};
+    return kUnboxed.count(type) ? "pyUnbox<" + type + ">(" + arg + ")" : arg;
+}
+
+// Point(1.5, y=2.0) for a class lowered to a struct: aggregate
+// initialization in field order, each argument converted to its field's
+// type. close is set as for emitSortCall.
+std::string emitStructCall(const std::string& name, const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    const StructInfo& info = knownStructs().at(name);
+    std::vector<std::string> values(info.fields.size());
+    std::size_t position = 0;
+    for (const auto& arg : splitArguments(tokens, open)) {
+        std::string text = lineText(arg);
+        std::smatch match;
+        std::size_t field = position;
+        if (text.empty()) {
+            continue;
+        }
+        if (std::regex_match(text, match, std::regex(R"((\w+)\s*=\s*([^=].*))"))) {
+            field = 0;
+            while (field < info.fields.size() && info.fields[field].first != match[1]) {
+                ++field;
+            }
+            text = match[2];
+        } else {
+            ++position;
+        }
+        if (field >= info.fields.size()) {
+            throw std::runtime_error(name + "() takes no argument " + text);
+        }
+        values[field] = emitFieldArgument(info.fields[field].second, translateExpr(toNodes(text)));
+    }
+    std::string code;
+    for (const auto& value : values) {
+        code += (code.empty() ? "" : ", ") + value;
+    }
+    return name + "{" + code + "}" + callRest(tokens, open, close);
+}
+
+// threading.Thread(target=f, args=(...)) and ThreadPoolExecutor(max_workers=n),
+// given their runtime names. The thread's args are spread into PyThread's
+// constructor, which stores them with the target. close is set as for
+// emitSortCall.
+std::string emitThreadCall(const std::string& type, const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    static const std::regex kKeyword(R"((\w+)\s*=\s*([^=][\s\S]*))");
+    std::string target;
+    std::string args;
+    std::string workers;
+    for (const auto& arg : splitArguments(tokens, open)) {
+        std::string text = lineText(arg);
+        std::smatch match;
+        std::string keyword = std::regex_match(text, match, kKeyword) ? match[1].str() : "";
+        std::string value = keyword.empty() ? text : match[2].str();
+        if (text.empty()) {
+            continue;
+        } else if (type == "PyThread" && keyword == "target") {
+            target = translateExpr(toNodes(value));
+        } else if (type == "PyThread" && keyword == "args" && value.front() == '(' && value.back() == ')') {
+            for (const auto& item : splitTopLevel(toNodes(value.substr(1, value.size() - 2)))) {
+                if (!lineText(item).empty()) {
+                    args += ", " + translateExpr(toNodes(lineText(item)));
+                }
+            }
+        } else if (type == "PyThreadPoolExecutor" && (keyword == "max_workers" || keyword.empty()) && workers.empty()) {
+            workers = emitIndex(toNodes(value));
+        } else {
+            throw std::runtime_error(type + ": unsupported argument " + text);
+        }
+    }
+    if (type == "PyThread" && target.empty()) {
+        throw std::runtime_error("threading.Thread() needs a target");
+    }
+    startsThreads() = true;
+    return type + "(" + (type == "PyThread" ? target + args : workers) + ")" + callRest(tokens, open, close);
+}
+
+// The C++ type a tuple expression spells out in front of its elements,
+// PyTuple<...>, or "" if code does not start with one.
+std::string tupleType(const std::string& code) {
+    if (code.rfind("PyTuple<", 0) != 0) {
+        return "";
+    }
+    int depth = 0;
+    for (std::size_t c = 0; c < code.size(); ++c) {
+        depth += (code[c] == '<') - (code[c] == '>');
+        if (depth == 0 && code[c] == '>') {
+            return code.substr(0, c + 1);
+        }
+    }
+    return "";
+}
+
+// A parenthesized expression list, (a, b) or (a,), opened by the last
+// character of tokens[open], is a tuple of known arity: a std::tuple, so
+// its elements sit at fixed offsets. Elements keep the type of a typed
+// local, struct or nested tuple and are boxed otherwise. close is set to
+// the token holding the closing parenthesis. Returns "" for a grouping or
+// generator expression.
+std::string emitTupleExpr(const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    std::vector<Node> inner;
+    std::string rest;
+    close = bracketClose(tokens, open, inner, rest);
+    std::vector<std::vector<Node>> parts = splitTopLevel(inner);
+    if (close == tokens.size() || parts.size() < 2 || lineText(inner).rfind("lambda", 0) == 0) {
+        return "";
+    }
+    std::string types;
+    std::string values;
+    for (std::size_t p = 0; p < parts.size(); ++p) {
+        std::string text = lineText(parts[p]);
+        if (text.empty() && p + 1 == parts.size() && p > 0) {
+            break;
+        }
+        std::string value = translateExpr(parts[p]);
+        value.erase(0, value.find_first_not_of(" \t"));
+        std::string type = tupleType(value);
+        std::size_t brace = value.find('{');
+        if (isTypedLocal(text)) {
+            type = currentScope().locals.at(text);
+        } else if (brace != std::string::npos && knownStructs().count(value.substr(0, brace))) {
+            type = value.substr(0, brace);
+        }
+        types += (types.empty() ? "" : ", ") + (type.empty() ? "PyValue" : type);
+        values += (values.empty() ? "" : ", ") + value;
+    }
+    return "PyTuple<" + types + ">(" + values + ")" + rest;
+}
+
+// A "(" ending tokens[i] groups rather than calls unless it follows a name,
+// a call, a subscript or a string.
+bool opensGroup(const std::vector<Node>& tokens, std::size_t i) {
+    const std::string& value = tokens[i].value;
+    if (value.size() > 1) {
+        char before = value[value.size() - 2];
+        return before != ')' && before != ']';
+    }
+    std::size_t previous = i;
+    while (previous > 0 && isWhitespace(tokens[previous - 1].value)) {
+        --previous;
+    }
+    if (previous == 0) {
+        return true;
+    }
+    const std::string& before = tokens[previous - 1].value;
+    return !(isName(before) && before != "in" && before != "and" && before != "or" && before != "not"
+             && before != "return" && before != "yield") && before.back() != ')' && before.back() != ']'
+           && !isStringToken(before);
+}
+
+// The function argument of map() or filter(): a def, a builtin or a
+// one-line lambda. It becomes a generic lambda, so it accepts whatever the
+// adapter hands out (an index from enumerate, a PyValue from a list).
+std::string emitCallable(const std::vector<Node>& arg) {
+    std::string text = lineText(arg);
+    std::smatch match;
+    if (std::regex_match(text, match, std::regex(R"(lambda\s*([\w\s,]*?)\s*:\s*(.+))"))) {
+        std::string params;
+        for (const auto& name : toNodes(match[1])) {
+            if (isName(name.value)) {
+                params += (params.empty() ? "" : ", ") + std::string("const auto& ") + name.value;
+            }
+        }
+        return "[&](" + params + ") { return PyValue(" + translateExpr(toNodes(match[2])) + "); }";
+    }
+    std::string f = knownFunctions().count(text) ? text : emitBuiltin(text, 1);
+    return "[&](const auto&... items) { return PyValue(" + f + "(items...)); }";
+}
+
+// sorted(items, key=f, reverse=r), or list.sort(...) when self is the
+// list. The key goes through emitCallable, so defs, builtins and lambdas
+// pass alike; any other argument is an error. close is set to the token
+// holding the closing parenthesis, and whatever follows it in that token
+// is kept.
+std::string emitSortCall(const std::string& self, const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    static const std::regex kKeyword(R"((\w+)\s*=\s*([^=][\s\S]*))");
+    std::string call = self.empty() ? "sorted()" : "sort()";
+    std::string items = self;
+    std::string key;
+    std::string reverse;
+    for (const auto& arg : splitArguments(tokens, open)) {
+        std::string text = lineText(arg);
+        std::smatch match;
+        if (text.empty()) {
+            continue;
+        } else if (!std::regex_match(text, match, kKeyword)) {
+            if (!items.empty()) {
+                throw std::runtime_error(call + " takes " + (self.empty() ? "one positional argument" : "no positional arguments"));
+            }
+            items = translateExpr(arg);
+        } else if (match[1] == "key") {
+            key = match[2] == "None" ? "" : emitCallable(toNodes(match[2]));
+        } else if (match[1] == "reverse") {
+            reverse = match[2] == "True" ? "true" : match[2] == "False" ? "" : "(" + translateExpr(toNodes(match[2])) + ").truthy()";
+        } else {
+            throw std::runtime_error(call + " got an unexpected keyword argument '" + match[1].str() + "'");
+        }
+    }
+    std::string rest = callRest(tokens, open, close);
+    if (!key.empty() && reverse.empty()) {
+        reverse = "false";
+    }
+    return std::string(self.empty() ? "pySorted(" : "pySort(") + items + (key.empty() ? "" : ", " + key) +
+           (reverse.empty() ? "" : ", " + reverse) + ")" + rest;
+}
+
+// enumerate, zip, map, filter and reversed become the lazy views of
+// pyiter.h; nested calls nest the views, so a chain of them is one loop
+// with no list or boxed tuple built in between. close is set as for
+// emitSortCall.
+std::string emitIterCall(const std::string& name, const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    std::vector<std::vector<Node>> args = splitArguments(tokens, open);
+    // A lambda's parameter list has commas of its own: it runs up to the
+    // colon, and its body to the next comma after that.
+    if (!args.empty() && lineText(args[0]).rfind("lambda", 0) == 0) {
+        while (args.size() > 1 && lineText(args[0]).find(':') == std::string::npos) {
+            args[0].push_back(Node{",", {}});
+            args[0].insert(args[0].end(), args[1].begin(), args[1].end());
+            args.erase(args.begin() + 1);
+        }
+    }
+    std::string code;
+    for (std::size_t a = 0; a < args.size(); ++a) {
+        std::string text = lineText(args[a]);
+        std::smatch match;
+        std::string arg;
+        if (text.empty() || (a == 0 && name == "filter" && text == "None")) {
+            continue;
+        } else if (name == "enumerate" && std::regex_match(text, match, std::regex(R"(start\s*=\s*(.+))"))) {
+            arg = emitIndex(toNodes(match[1]));
+        } else if (name == "enumerate" && a == 1) {
+            arg = emitIndex(args[a]);
+        } else if (a == 0 && (name == "map" || name == "filter")) {
+            arg = emitCallable(args[a]);
+        } else {
+            arg = translateExpr(args[a]);
+        }
+        code += (code.empty() ? "" : ", ") + arg;
+    }
+    std::string rest = callRest(tokens, open, close);
+    return emitBuiltin(name, args.size()) + "(" + code + ")" + rest;
+}
+
+std::string translateExpr(const std::vector<Node>& input) {
+    static const std::regex kStringLiteral(R"(".*?")");
+    static const std::set<std::string> kIterBuiltins = {"enumerate", "zip", "map", "filter", "reversed"};
+    bool glued = std::any_of(input.begin(), input.end(), [](const Node& token) { return gluesBracket(token.value); });
+    std::vector<Node> split;
+    if (glued) {
+        split = splitBrackets(input);
+    }
+    const std::vector<Node>& tokens = glued ? split : input;
+    std::string code;
+    std::string comprehension;
+    std::size_t close = 0;
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const std::string& value = tokens[i].value;
+        std::size_t next = nextToken(tokens, i);
+        std::size_t operand = next < tokens.size() ? nextToken(tokens, next) : next;
+        if (value == "set" && next == i + 1 && next < tokens.size() && tokens[next].value.rfind("()", 0) == 0) {
+            code += emitSetType("PyValue") + tokens[next].value;
+            i = next;
+        } else if ((isName(value) || isIntLiteral(value) || isStringToken(value)) && next < tokens.size()
+                   && tokens[next].value == "in" && operand < tokens.size() && isName(tokens[operand].value)) {
+            code += emitMembership(translateExpr({tokens[i]}), translateExpr({tokens[operand]}));
+            i = operand;
+        } else if (std::regex_match(value, kStringLiteral)) {
+            code += emitStrLiteral(value);
+        } else if (isIntLiteral(value) && next == i + 1 && next < tokens.size() && tokens[next].value == "."
+                   && next + 1 < tokens.size() && isIntLiteral(tokens[next + 1].value)) {
+            code += emitDynamicValue(value + "." + tokens[next + 1].value);
+            i = next + 1;
+        } else if (isIntLiteral(value)) {
+            code += emitIntLiteral(value);
+        } else if (value == "sorted" && next == i + 1 && next < tokens.size() && tokens[next].value[0] == '(') {
+            code += emitSortCall("", tokens, next, i);
+        } else if (kIterBuiltins.count(value) && next == i + 1
+                   && next < tokens.size() && tokens[next].value[0] == '(') {
+            code += emitIterCall(value, tokens, next, i);
+        } else if (knownStructs().count(value) && next == i + 1 && next < tokens.size() && tokens[next].value[0] == '(') {
+            code += emitStructCall(value, tokens, next, i);
+        } else if (isName(value) && next == i + 1 && next < tokens.size() && tokens[next].value[0] == '(') {
+            // Callees are functions, not values.
+            code += emitBuiltin(value, splitArguments(tokens, next).size());
+        } else if (value == "await") {
+            code += "co_await";
+        } else if (isName(value) && next == i + 1 && next < tokens.size() && tokens[next].value == ".") {
+            // Attribute chains read struct members directly.
+            std::string chain;
+            while (i + 2 < tokens.size() && tokens[i + 1].value == "." && isName(tokens[i + 2].value)) {
+                chain += tokens[i].value + ".";
+                i += 2;
+            }
+            chain += tokens[i].value;
+            std::string self = chain.size() > 5 ? chain.substr(0, chain.size() - 5) : "";
+            std::size_t dot = chain.find('.');
+            std::string method = dot == std::string::npos ? "" : chain.substr(chain.rfind('.'));
+            if (chain.size() > 5 && chain.compare(chain.size() - 5, 5, ".sort") == 0 && isListLocal(self)
+                && i + 1 < tokens.size() && tokens[i + 1].value[0] == '(') {
+                code += emitSortCall(self, tokens, i + 1, i);
+            } else if ((method == ".add" || method == ".discard") && isSetLocal(chain.substr(0, chain.size() - method.size()))) {
+                // set.add and set.discard are PySet's insert and erase;
+                // both ignore a key that is already present or absent.
+                code += chain.substr(0, chain.size() - method.size()) + (method == ".add" ? ".insert" : ".erase");
+            } else if (cachedFunctions().count(chain.substr(0, dot))
+                       && (chain.substr(dot) == ".cache_info" || chain.substr(dot) == ".cache_clear")) {
+                code += chain.substr(0, dot) + (chain.substr(dot) == ".cache_info" ? "Cache.cacheInfo" : "Cache.cacheClear");
+            } else if ((emitModuleCall(chain) == "PyThread" || emitModuleCall(chain) == "PyThreadPoolExecutor")
+                       && i + 1 < tokens.size() && tokens[i + 1].value[0] == '(') {
+                code += emitThreadCall(emitModuleCall(chain), tokens, i + 1, i);
+            } else {
+                code += emitModuleCall(chain);
+            }
+        } else if (knownFunctions().count(value) || isTypedLocal(value)) {
+            code += value;
+        } else if (isName(value)) {
+            // Nothing is inferred about names yet, so they go through PyValue.
+            code += emitDynamicValue(value);
+        } else if ((value.back() == '[' || value.back() == '{')
+                   && !(comprehension = emitComprehension(tokens, i, close)).empty()) {
+            code += value.substr(0, value.size() - 1) + comprehension;
+            i = close;
+        } else if (value.back() == '{' && !(comprehension = emitSetLiteral(tokens, i, close)).empty()) {
+            code += value.substr(0, value.size() - 1) + comprehension;
+            i = close;
+        } else if (value.back() == '(' && opensGroup(tokens, i)
+                   && !(comprehension = emitTupleExpr(tokens, i, close)).empty()) {
+            code += value.substr(0, value.size() - 1) + comprehension;
+            i = close;
+        } else if (opensListLiteral(tokens, i)) {
+            std::vector<std::vector<Node>> elements;
+            std::size_t close = collectListElements(tokens, i, elements);
+            if (close < tokens.size()) {
+                code += emitListLiteral(elements);
+                i = close;
+            } else {
+                code += value;
+            }
+        } else {
+            code += value;
+        }
+    }
+    return code;
+}
+
+// Indentation of the line after node, or npos if the next keyword follows
+// on the same line.
+std::size_t trailingIndent(const Node& node) {
+    for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+        std::size_t newline = it->value.rfind('\n');
+        if (newline != std::string::npos) {
+            return it->value.size() - newline - 1;
+        }
+        if (!isWhitespace(it->value)) {
+            break;
+        }
+    }
+    return std::string::npos;
+}
+
+// Index of the token that ends a block header: the first one ending in ':'
+// outside brackets, so parameter annotations do not end a def header.
+std::size_t headerEnd(const Node& node) {
+    int depth = 0;
+    std::size_t i = 0;
+    for (; i < node.children.size(); ++i) {
+        for (char c : node.children[i].value) {
+            depth += (c == '(' || c == '[') - (c == ')' || c == ']');
+        }
+        if (depth == 0 && node.children[i].value.back() == ':') {
+            break;
+        }
+    }
+    return i;
+}
+
+// Index of the token that ends the node's first line.
+std::size_t lineEnd(const Node& node) {
+    std::size_t i = 0;
+    while (i < node.children.size() && node.children[i].value.find('\n') == std::string::npos) {
+        ++i;
+    }
+    return i;
+}
+
+// A line that is just a call, e.g. asyncio.create_task(worker()).
+bool isCallStatement(const std::vector<Node>& line, std::size_t first) {
+    std::size_t i = first;
+    while (i + 2 < line.size() && isName(line[i].value) && line[i + 1].value == ".") {
+        i += 2;
+    }
+    return isName(line[i].value) && i + 1 < line.size() && line[i + 1].value[0] == '(';
+}
+
+// name = expr declares a local on first assignment; name op= expr is
+// spelled out because PyValue has only the binary operators. So is
+// obj.field op= expr, whose result is unboxed to the field's type when obj
+// is a struct or the Ref of one.
+std::string emitAssignment(const std::string& text) {
+    static const std::regex kAugmented(R"((\w+)\s*([-+*])=\s*(.+))");
+    static const std::regex kAttribute(R"((\w+)\.(\w+)\s*([-+*/])=\s*(.+))");
+    static const std::regex kPlain(R"((\w+)\s*=\s*([^=].*))");
+    static const std::regex kBuilt(R"(^\[&\] \{\n(.+) items;\n)");
+    static const std::regex kThreads(R"(^(PyThread|PyThreadPoolExecutor)\()");
+    static const std::regex kSubmit(R"((\w+)\.submit\([\s\S]*\))");
+    std::smatch match;
+    if (std::regex_match(text, match, kAugmented)) {
+        return match[1].str() + " = " + match[1].str() + " " + match[2].str() + " (" + translateExpr(toNodes(match[3])) + ");\n";
+    }
+    if (std::regex_match(text, match, kAttribute)) {
+        std::string target = match[1].str() + "." + match[2].str();
+        std::string value = target + " " + match[3].str() + " (" + translateExpr(toNodes(match[4])) + ")";
+        auto local = currentScope().locals.find(match[1]);
+        std::string type = local == currentScope().locals.end() ? "" : local->second;
+        type = type.size() > 3 && type.compare(type.size() - 3, 3, "Ref") == 0 ? type.substr(0, type.size() - 3) : type;
+        auto known = knownStructs().find(type);
+        if (known != knownStructs().end()) {
+            for (const auto& field : known->second.fields) {
+                value = field.first == match[2] ? emitFieldArgument(field.second, value) : value;
+            }
+        }
+        return target + " = " + value + ";\n";
+    }
+    if (std::regex_match(text, match, kPlain)) {
+        std::string value = translateExpr(toNodes(match[2]));
+        // A list literal or sorted() makes the local a PyList, so loops reach
+        // its storage, and set() or a set display a PySet; a comprehension
+        // gives it the type it builds. So does a tuple expression, a
+        // struct's constructor or a thread or pool; a submitted task's
+        // future is whatever PyFuture the pool returns.
+        bool list = value.rfind("PyList", 0) == 0 || value.rfind("pySorted(", 0) == 0;
+        std::string set = emitSetType("PyValue");
+        std::smatch built;
+        std::string type = list ? "PyList" : value.rfind(set, 0) == 0 ? set : "PyValue";
+        std::size_t brace = value.find('{');
+        if (std::regex_search(value, built, kBuilt)) {
+            type = built[1];
+        } else if (!tupleType(value).empty()) {
+            type = tupleType(value);
+        } else if (brace != std::string::npos && knownStructs().count(value.substr(0, brace))) {
+            type = value.substr(0, brace);
+        } else if (brace != std::string::npos && !soaElement(value.substr(0, brace)).empty()) {
+            type = value.substr(0, brace);
+        } else if (std::regex_search(value, built, kThreads)) {
+            type = built[1];
+        } else if (std::regex_match(value, built, kSubmit) && currentScope().locals.count(built[1])
+                   && currentScope().locals.at(built[1]) == "PyThreadPoolExecutor") {
+            type = "auto";
+        }
+        if (currentScope().globals.erase(match[1])) {
+            currentScope().locals.erase(match[1]);
+        }
+        bool declared = !currentScope().locals.emplace(match[1], type).second;
+        return (declared ? "" : type + " ") + match[1].str() + " = " + value + ";\n";
+    }
+    return "";
+}
+
+// Indentation and closing text of every open def/for block.
+typedef std::vector<std::pair<std::size_t, std::string>> BlockStack;
+
+// Closes the blocks a line at this indentation has left.
+std::string closeBlocks(BlockStack& blocks, std::size_t indent) {
+    std::string code;
+    while (!blocks.empty() && indent <= blocks.back().first) {
+        code += blocks.back().second;
+        blocks.pop_back();
+    }
+    return code;
+}
+
+// A for target as a pattern: a node per name, and an unnamed node per
+// parenthesized group holding its names. The outermost node is the whole
+// target list.
+Node parseTarget(const std::vector<Node>& tokens) {
+    Node pattern;
+    std::vector<Node*> groups = {&pattern};
+    for (const auto& token : tokens) {
+        if (isName(token.value)) {
+            groups.back()->children.push_back(Node{token.value, {}});
+            continue;
+        }
+        for (char c : token.value) {
+            if (c == '(') {
+                groups.back()->children.emplace_back();
+                groups.push_back(&groups.back()->children.back());
+            } else if (c == ')' && groups.size() > 1) {
+                groups.pop_back();
+            }
+        }
+    }
+    while (pattern.children.size() == 1 && pattern.children[0].value.empty()) {
+        Node group = pattern.children[0];
+        pattern = group;
+    }
+    return pattern;
+}
+
+// Binds a for target pattern: a name binds directly, a parenthesized group
+// binds a hidden <first name>Items that unpack re-binds at the top of the
+// body, since structured bindings do not nest.
+std::string emitBinding(const Node& target, std::string& unpack) {
+    if (!target.value.empty()) {
+        return target.value;
+    }
+    std::string binding;
+    for (const auto& child : target.children) {
+        std::string name = child.value;
+        if (name.empty()) {
+            const Node* first = &child;
+            while (first->value.empty() && !first->children.empty()) {
+                first = &first->children[0];
+            }
+            name = first->value + "Items";
+            std::string nested;
+            unpack += "auto&& " + emitBinding(child, nested) + " = " + name + ";\n" + nested;
+        }
+        binding += (binding.empty() ? "[" : ", ") + name;
+    }
+    return binding + "]";
+}
+
+// One clause of a comprehension, in source order: for target in tokens, if
+// tokens, or, once an inner comprehension is fused in, the binding of
+// target to the inner one's element.
+struct ComprehensionClause {
+    enum Kind { FOR, IF, BIND };
+    Kind kind;
+    Node target;
+    std::vector<Node> tokens;
+};
+
+// [element ...], {element ...} or {key: element ...} with its clauses.
+struct Comprehension {
+    char bracket = '[';
+    std::vector<Node> key;
+    std::vector<Node> element;
+    std::vector<ComprehensionClause> clauses;
+};
+
+// Splits what is between a comprehension's brackets at its top-level for,
+// in and if, and a dict's element at its top-level colon. Returns false
+// for anything without a top-level for (a literal) and for async for.
+bool parseComprehension(const std::vector<Node>& inner, char bracket, Comprehension& comprehension) {
+    comprehension = Comprehension{bracket, {}, {}, {}};
+    std::vector<Node> target;
+    bool inTarget = false;
+    int depth = 0;
+    for (const auto& token : inner) {
+        const std::string& value = token.value;
+        if (depth == 0 && value == "async") {
+            return false;
+        } else if (depth == 0 && value == "for") {
+            comprehension.clauses.push_back({ComprehensionClause::FOR, Node(), {}});
+            target.clear();
+            inTarget = true;
+        } else if (depth == 0 && inTarget && value == "in") {
+            comprehension.clauses.back().target = parseTarget(target);
+            inTarget = false;
+        } else if (depth == 0 && !inTarget && value == "if" && !comprehension.clauses.empty()) {
+            comprehension.clauses.push_back({ComprehensionClause::IF, Node(), {}});
+        } else {
+            for (char c : isStringToken(value) ? std::string() : value) {
+                depth += (c == '(' || c == '[' || c == '{') - (c == ')' || c == ']' || c == '}');
+            }
+            if (inTarget) {
+                target.push_back(token);
+            } else {
+                (comprehension.clauses.empty() ? comprehension.element : comprehension.clauses.back().tokens).push_back(token);
+            }
+        }
+    }
+    if (comprehension.clauses.empty() || inTarget) {
+        return false;
+    }
+    depth = 0;
+    for (std::size_t t = 0; bracket == '{' && t < comprehension.element.size(); ++t) {
+        const std::string value = comprehension.element[t].value;
+        for (std::size_t c = 0; c < value.size() && !isStringToken(value); ++c) {
+            depth += (value[c] == '(' || value[c] == '[' || value[c] == '{') - (value[c] == ')' || value[c] == ']' || value[c] == '}');
+            if (depth == 0 && value[c] == ':') {
+                comprehension.key.assign(comprehension.element.begin(), comprehension.element.begin() + std::ptrdiff_t(t));
+                comprehension.key.push_back(Node{value.substr(0, c), {}});
+                std::vector<Node> element = {Node{value.substr(c + 1), {}}};
+                element.insert(element.end(), comprehension.element.begin() + std::ptrdiff_t(t) + 1, comprehension.element.end());
+                comprehension.element = element;
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+// Every name a target pattern binds.
+void targetNames(const Node& target, std::set<std::string>& names) {
+    if (!target.value.empty()) {
+        names.insert(target.value);
+    }
+    for (const auto& child : target.children) {
+        targetNames(child, names);
+    }
+}
+
+// name = [list comprehension] where the name occurs once more in the
+// function: the comprehension is held back in FunctionScope::deferred
+// rather than built, so the next statement can fuse it.
+bool deferComprehension(const std::string& text) {
+    std::smatch match;
+    if (!std::regex_match(text, match, std::regex(R"((\w+)\s*=\s*(\[.*\]))")) || currentScope().locals.count(match[1])
+        || currentScope().uses[match[1]] != 2) {
+        return false;
+    }
+    std::vector<Node> tokens = toNodes(match[2]);
+    std::vector<Node> between;
+    std::string rest;
+    Comprehension comprehension;
+    if (bracketClose(tokens, 0, between, rest) + 1 != tokens.size() || !parseComprehension(between, '[', comprehension)) {
+        return false;
+    }
+    currentScope().deferred.emplace_back(match[1], match[2]);
+    currentScope().locals.emplace(match[1], "PyList");
+    return true;
+}
+
+std::vector<std::pair<std::string, std::string>>::iterator findDeferred(const std::string& name) {
+    std::vector<std::pair<std::string, std::string>>& deferred = currentScope().deferred;
+    return std::find_if(deferred.begin(), deferred.end(), [&name](const auto& held) { return held.first == name; });
+}
+
+// Declares a held-back comprehension local after all. Translating it may
+// fuse the held-back locals it reads; any it does not are declared first.
+std::string emitDeferred(const std::string& name) {
+    auto held = findDeferred(name);
+    if (held == currentScope().deferred.end()) {
+        return "";
+    }
+    std::vector<Node> source = toNodes(held->second);
+    currentScope().deferred.erase(held);
+    std::string value = translateExpr(source);
+    std::string code;
+    for (const auto& token : source) {
+        code += emitDeferred(token.value);
+    }
+    return code + "PyList " + name + " = " + value + ";\n";
+}
+
+std::string emitAllDeferred() {
+    std::string code;
+    while (!currentScope().deferred.empty()) {
+        code += emitDeferred(currentScope().deferred.back().first);
+    }
+    return code;
+}
+
+// The statements a node carries after its header. Calls, assignments,
+// return, yield and await are lowered; yield from re-yields every item of
+// the inner iterable. A line that dedents closes the blocks it leaves, so
+// statements after a nested block land in the enclosing one. A held-back
+// comprehension that the statement after it does not fuse is declared
+// just before that statement.
+std::string emitBody(const Node& node, std::size_t start, BlockStack& blocks) {
+    std::string code;
+    std::vector<Node> line;
+    std::size_t indent = std::string::npos;
+    for (std::size_t i = start; i <= node.children.size(); ++i) {
+        if (i < node.children.size() && node.children[i].value.find('\n') == std::string::npos) {
+            line.push_back(node.children[i]);
+            continue;
+        }
+        if (indent != std::string::npos && !lineText(line).empty()) {
+            std::string closing = closeBlocks(blocks, indent);
+            code += closing.empty() ? "" : emitAllDeferred() + closing;
+            if (blocks.empty()) {
+                currentScope().uses.clear();
+            }
+        }
+        if (i < node.children.size()) {
+            indent = node.children[i].value.size() - node.children[i].value.rfind('\n') - 1;
+        }
+        std::vector<std::string> held;
+        for (auto it = currentScope().deferred.rbegin(); it != currentScope().deferred.rend(); ++it) {
+            held.push_back(it->first);
+        }
+        std::string statement;
+        std::size_t first = line.empty() || !isWhitespace(line[0].value) ? 0 : nextToken(line, 0);
+        bool named = first < line.size() && isName(line[first].value);
+        bool deferred = named && deferComprehension(lineText(line));
+        std::string assignment = named && !deferred ? emitAssignment(lineText(line)) : "";
+        if (deferred) {
+            // Whatever it reads that is held back stays held with it.
+            for (const auto& token : line) {
+                held.erase(std::remove(held.begin(), held.end(), token.value), held.end());
+            }
+        } else if (first < line.size() && line[first].value == "return") {
+            std::vector<Node> value(line.begin() + std::ptrdiff_t(first) + 1, line.end());
+            bool bare = lineText(value).empty();
+            statement += currentScope().returnKeyword + (bare ? "" : " " + translateExpr(value)) + ";\n";
+        } else if (!assignment.empty()) {
+            statement += assignment;
+            if (blocks.empty()) {
+                // A module global: functions read a typed one directly
+                // rather than boxing a copy of it.
+                const std::string& type = currentScope().locals.at(line[first].value);
+                if (type != "PyValue" && type != "auto") {
+                    moduleGlobals()[line[first].value] = type;
+                } else {
+                    moduleGlobals().erase(line[first].value);
+                }
+            }
+        } else if (first < line.size() && (line[first].value == "await" || isCallStatement(line, first))) {
+            statement += translateExpr(std::vector<Node>(line.begin() + std::ptrdiff_t(first), line.end())) + ";\n";
+        } else if (first < line.size() && line[first].value == "yield") {
+            std::size_t from = nextToken(line, first);
+            if (from < line.size() && line[from].value == "from") {
+                std::vector<Node> inner(line.begin() + std::ptrdiff_t(from) + 1, line.end());
+                statement += "for (auto&& item : " + translateExpr(inner) + ") {\nco_yield item;\n}\n";
+            } else {
+                std::vector<Node> value(line.begin() + std::ptrdiff_t(first) + 1, line.end());
+                statement += "co_yield " + (from < line.size() ? translateExpr(value) : "PyValue()") + ";\n";
+            }
+        }
+        for (const auto& name : held) {
+            code += emitDeferred(name);
+        }
+        code += statement;
+        line.clear();
+    }
+    return code + emitAllDeferred();
+}
+
+// Index one past the last keyword nested in the block opened by root.children[i].
+std::size_t blockEnd(const Node& root, std::size_t i, const std::vector<std::size_t>& indents) {
+    std::size_t j = i + 1;
+    while (j < root.children.size() && indents[j] > indents[i]) {
+        ++j;
+    }
+    return j;
+}
+
+// A def containing yield, directly or in a nested block, is a generator.
+bool isGenerator(const Node& root, std::size_t i, const std::vector<std::size_t>& indents) {
+    for (std::size_t j = i; j < blockEnd(root, i, indents); ++j) {
+        for (const auto& token : root.children[j].children) {
+            if (token.value == "yield") {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// How often each name occurs in the block opened by root.children[i].
+std::map<std::string, int> countUses(const Node& root, std::size_t i, const std::vector<std::size_t>& indents) {
+    std::map<std::string, int> uses;
+    for (std::size_t j = i; j < blockEnd(root, i, indents); ++j) {
+        for (const auto& token : root.children[j].children) {
+            uses[token.value] += isName(token.value);
+        }
+    }
+    return uses;
+}
+
+bool returnsValue(const Node& root, std::size_t i, const std::vector<std::size_t>& indents) {
+    for (std::size_t j = i; j < blockEnd(root, i, indents); ++j) {
+        const std::vector<Node>& tokens = root.children[j].children;
+        for (std::size_t t = 0; t < tokens.size(); ++t) {
+            std::size_t next = nextToken(tokens, t);
+            if (tokens[t].value == "return" && next < tokens.size() && next == t + 2
+                && tokens[t + 1].value.find('\n') == std::string::npos) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// True when every call in tokens goes to a pure function.
+bool callsArePure(const std::vector<Node>& tokens, const std::string& self) {
+    for (std::size_t t = 0; t + 1 < tokens.size(); ++t) {
+        if (isName(tokens[t].value) && tokens[t + 1].value[0] == '(' && tokens[t].value != self
+            && !pureFunctions().count(tokens[t].value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The effect analysis behind loop parallelization: a def is pure if its
+// block prints nothing, nests no other blocks but for loops, stores only to
+// plain local names and calls only pure functions.
+bool isPure(const Node& root, std::size_t i, const std::vector<std::size_t>& indents, const std::string& name) {
+    for (std::size_t j = i; j < blockEnd(root, i, indents); ++j) {
+        const Node& child = root.children[j];
+        if (j > i && child.value != "for") {
+            return false;
+        }
+        if (!callsArePure(child.children, name)) {
+            return false;
+        }
+        for (std::size_t t = 0; t < child.children.size(); ++t) {
+            const std::string& value = child.children[t].value;
+            if (value == "yield" || value == "await" || value == "global" || value == "nonlocal") {
+                return false;
+            }
+            // Stores through a subscript or attribute write to shared state.
+            bool store = value == "=" || (value.size() == 2 && value[1] == '=' && std::string("+-*/").find(value[0]) != std::string::npos);
+            std::size_t before = t;
+            while (store && before > 0 && isWhitespace(child.children[before - 1].value)
+                   && child.children[before - 1].value.find('\n') == std::string::npos) {
+                --before;
+            }
+            if (store && (before == 0 || !isName(child.children[before - 1].value)
+                          || (before >= 2 && child.children[before - 2].value == "."))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The name a def header declares.
+std::string functionName(const Node& node) {
+    std::size_t first = node.children.empty() ? 0 : nextToken(node.children, 0);
+    if (!node.children.empty() && isName(node.children[0].value)) {
+        first = 0;
+    }
+    return first < node.children.size() ? node.children[first].value : "";
+}
+
+// Parameters arrive as PyValue unless annotated as a list; a list is
+// passed by reference, const unless the body calls its methods. Generators
+// return a PyGenerator and async functions a PyTask; both bodies run as
+// coroutines.
+std::string emitFunction(const Node& node, const std::string& returnType) {
+    std::size_t end = headerEnd(node);
+    bool coroutine = returnType.rfind("PyGenerator", 0) == 0 || returnType.rfind("PyTask", 0) == 0;
+    FunctionScope scope;
+    scope.returnKeyword = coroutine ? "co_return" : "return";
+    currentScope() = scope;
+    std::string name = functionName(node);
+    knownFunctions().insert(name);
+    std::vector<Node> header(node.children.begin(), node.children.begin() + std::ptrdiff_t(std::min(end, node.children.size())));
+    std::size_t open = 0;
+    while (open < header.size() && header[open].value[0] != '(') {
+        ++open;
+    }
+    std::string params;
+    for (const auto& arg : splitArguments(header, open)) {
+        std::smatch match;
+        std::string text = lineText(arg);
+        if (!std::regex_match(text, match, std::regex(R"((\w+)\s*(:\s*([^=]*?))?\s*(=.*)?)"))) {
+            continue;
+        }
+        std::string param = match[1];
+        std::string annotated = match[3].matched ? emitFieldType(match[3]) : "";
+        std::string type = annotated == "PyList" || !soaElement(annotated).empty() ? annotated : "PyValue";
+        std::string declared = "PyValue ";
+        if (type != "PyList" && type != "PyValue") {
+            // Lists of structs are passed by reference, as Python shares them.
+            declared = type + "& ";
+        } else if (type == "PyList") {
+            bool mutated = false;
+            for (std::size_t i = end; i + 1 < node.children.size(); ++i) {
+                mutated = mutated || (node.children[i].value == param && node.children[i + 1].value == ".");
+            }
+            declared = mutated ? "PyList& " : "const PyList& ";
+        }
+        params += (params.empty() ? "" : ", ") + declared + param;
+        currentScope().locals.emplace(param, type);
+        currentScope().params.push_back(param);
+    }
+    for (const auto& global : moduleGlobals()) {
+        if (currentScope().locals.emplace(global.first, global.second).second) {
+            currentScope().globals.insert(global.first);
+        }
+    }
+    return returnType + " " + name + "(" + params + ") {\n";
+}
+
+// The maxsize of a functools.cache or lru_cache decorator on the last lines
+// of previous, i.e. just above the def that follows it: "-1" for None, ""
+// if there is no such decorator.
+std::string cacheDecorator(const Node& previous) {
+    std::vector<std::string> lines(1);
+    for (const auto& token : previous.children) {
+        if (token.value.find('\n') != std::string::npos) {
+            lines.emplace_back();
+        } else {
+            lines.back() += token.value;
+        }
+    }
+    for (auto line = lines.rbegin(); line != lines.rend(); ++line) {
+        std::string text = lineText({Node{*line, {}}});
+        if (text.empty()) {
+            continue;
+        }
+        if (text[0] != '@') {
+            break;
+        }
+        std::smatch match;
+        if (!std::regex_match(text, match, std::regex(R"(@\s*(functools\s*\.\s*)?(lru_cache|cache)\s*(\((.*)\))?)"))) {
+            continue;
+        }
+        std::smatch size;
+        std::string args = match[4];
+        if (match[2] == "cache" || std::regex_search(args, size, std::regex(R"(^\s*(maxsize\s*=\s*)?None\b)"))) {
+            return "-1";
+        }
+        if (std::regex_search(args, size, std::regex(R"(^\s*(maxsize\s*=\s*)?(-?\d+))"))) {
+            // CPython treats a negative maxsize as 0: nothing is cached.
+            return size[2].str()[0] == '-' ? "0" : size[2].str();
+        }
+        return "128";
+    }
+    return "";
+}
+
+// A memoized def: the body runs in a lambda through a PyLruCache keyed on
+// the arguments, so a recursive call that hits returns at once. A list
+// parameter could not be hashed in Python either; such a def is emitted
+// unmemoized.
+std::string emitCachedFunction(const Node& node, const std::string& returnType, const std::string& maxsize,
+                               std::string& close) {
+    std::string header = emitFunction(node, "PyValue");
+    std::string name = functionName(node);
+    std::string types;
+    std::string args;
+    for (const auto& param : currentScope().params) {
+        if (currentScope().locals[param] != "PyValue") {
+            close = "}\n";
+            return emitFunction(node, returnType);
+        }
+        types += ", PyValue";
+        args += ", " + param;
+    }
+    if (returnType == "void") {
+        currentScope().returnKeyword = "return PyValue()";
+    }
+    cachedFunctions().insert(name);
+    close = "return PyValue();\n}" + args + ");\n}\n";
+    return "PyLruCache<PyValue" + types + "> " + name + "Cache(" + maxsize + ");\n" + header + "return " + name +
+           "Cache.call([&]() -> PyValue {\n";
+}
+
+// The loop body as reductions {acc, expr, combine}, one per line of
+// `acc += expr` or `acc = min(acc, expr)` / max; empty if the body holds
+// anything else. end is set to where the body stops.
+std::vector<std::vector<std::string>> loopReductions(const Node& node, std::size_t start, std::size_t loopIndent, std::size_t& end) {
+    std::vector<std::vector<std::string>> reductions;
+    std::vector<Node> line;
+    end = start;
+    for (std::size_t i = start; i <= node.children.size(); ++i) {
+        if (i < node.children.size() && node.children[i].value.find('\n') == std::string::npos) {
+            line.push_back(node.children[i]);
+            continue;
+        }
+        std::string text = lineText(line);
+        line.clear();
+        end = i;
+        std::smatch match;
+        if (std::regex_match(text, match, std::regex(R"((\w+)\s*\+=\s*(.+))"))) {
+            reductions.push_back({match[1], match[2], "a + b"});
+        } else if (std::regex_match(text, match, std::regex(R"((\w+)\s*=\s*(min|max)\(\s*(\w+)\s*,\s*(.+)\))"))
+                   && match[1] == match[3]) {
+            reductions.push_back({match[1], match[4], "std::" + match[2].str() + "(a, b)"});
+        } else if (!text.empty()) {
+            return {};
+        }
+        // The next line leaves the loop body.
+        if (i < node.children.size() && node.children[i].value.size() - node.children[i].value.rfind('\n') - 1 <= loopIndent) {
+            break;
+        }
+    }
+    return reductions;
+}
+
+bool isValueLocal(const std::string& name) {
+    auto local = currentScope().locals.find(name);
+    return local != currentScope().locals.end() && local->second == "PyValue";
+}
+
+// Lowers `acc += expr` and `acc = min(acc, expr)` / max to a
+// pyParallelReduce call. Returns "" unless every line of the body is such a
+// reduction into a known local, with a pure expression that reads no
+// accumulator, so iterations are independent.
+std::string emitParallelReductions(const Node& node, std::size_t& start, std::size_t loopIndent,
+                                   const std::string& target, const std::string& from, const std::string& to) {
+    std::size_t end = start;
+    std::vector<std::vector<std::string>> reductions = loopReductions(node, start, loopIndent, end);
+    if (reductions.empty()) {
+        return "";
+    }
+    std::string code;
+    for (const auto& reduction : reductions) {
+        const std::string& acc = reduction[0];
+        std::vector<Node> expr = toNodes(reduction[1]);
+        if (acc == target || !isValueLocal(acc) || !callsArePure(expr, "")) {
+            return "";
+        }
+        for (std::size_t t = 0; t < expr.size(); ++t) {
+            const std::string& value = expr[t].value;
+            bool called = t + 1 < expr.size() && expr[t + 1].value[0] == '(';
+            if (!isName(value) || isIntLiteral(value) || called || value == target || (t > 0 && expr[t - 1].value == ".")) {
+                continue;
+            }
+            for (const auto& other : reductions) {
+                if (value == other[0]) {
+                    return "";
+                }
+            }
+        }
+        code += acc + " = pyParallelReduce(" + from + ", " + to + ", " + acc + ", [&](int64_t " + target +
+                ") -> PyValue { return " + translateExpr(expr) + "; }, [](const PyValue& a, const PyValue& b) { return " +
+                reduction[2] + "; }, " + std::to_string(codegenOptions().minParallelTrips) + ");\n";
+    }
+    // Pure functions may still read module globals, which nothing hands to
+    // the pool.
+    startsThreads() = true;
+    start = end;
+    return code;
+}
+
+// An element expression of a float loop as double arithmetic on hoisted
+// list pointers, reading element `at`. Elements are the loop target of a
+// loop over list `over`, or subscripts list[target] of an index loop
+// (over empty). Returns "" for anything else: calls, other names, ** // %
+// whose Python meaning differs, and division by anything but a nonzero
+// literal. Lists read are added to lists.
+std::string emitFloatExpr(const std::vector<Node>& expr, const std::string& target, const std::string& over,
+                          const std::string& at, std::set<std::string>& lists) {
+    static const std::regex kOperators(R"([-+*/() \t]*)");
+    std::string code;
+    for (std::size_t t = 0; t < expr.size(); ++t) {
+        const std::string& value = expr[t].value;
+        if (value == target && !over.empty()) {
+            lists.insert(over);
+            code += over + "Data[" + at + "]";
+        } else if (isListLocal(value) && over.empty() && t + 3 < expr.size() && expr[t + 1].value == "["
+                   && expr[t + 2].value == target && expr[t + 3].value[0] == ']') {
+            std::string rest = expr[t + 3].value.substr(1);
+            if (!std::regex_match(rest, kOperators) || rest.find("//") != std::string::npos) {
+                return "";
+            }
+            lists.insert(value);
+            code += value + "Data[" + at + "]" + rest;
+            t += 3;
+        } else if (isIntLiteral(value) && t + 2 < expr.size() && expr[t + 1].value == "." && isIntLiteral(expr[t + 2].value)) {
+            code += value + "." + expr[t + 2].value;
+            t += 2;
+        } else if (isIntLiteral(value)) {
+            code += value + ".0";
+        } else if (std::regex_match(value, kOperators) && value.find("**") == std::string::npos
+                   && value.find("//") == std::string::npos) {
+            // Division by an element could be by zero, which must raise.
+            std::size_t divisor = nextToken(expr, t);
+            if (value.back() == '/' && (divisor >= expr.size() || !isIntLiteral(expr[divisor].value)
+                                        || expr[divisor].value.find_first_not_of('0') == std::string::npos)) {
+                return "";
+            }
+            code += value;
+        } else {
+            return "";
+        }
+    }
+    return code;
+}
+
+// A float reduction loop in the form GCC and Clang vectorize without
+// -ffast-math: the trip count is hoisted, lists are read through
+// __restrict pointers with no checks in the body, and each sum is split
+// over four accumulators so the lanes are independent. It runs when every
+// list read holds unboxed floats and is long enough; otherwise the loop
+// runs as written (generic header, closed by close). Sums may differ from
+// a serial loop in the last bits.
+std::string emitVectorLoop(const Node& node, std::size_t bodyStart, std::size_t loopIndent, const std::string& target,
+                           const std::string& over, const std::string& stop, const std::string& generic, std::string& close) {
+    std::size_t end = bodyStart;
+    std::vector<std::vector<std::string>> reductions = loopReductions(node, bodyStart, loopIndent, end);
+    if (reductions.empty() || codegenOptions().strictFloatOrder) {
+        return "";
+    }
+    const std::string count = target + "Count";
+    const std::string at = target + "At";
+    std::set<std::string> lists;
+    std::vector<std::vector<std::string>> lanes;
+    for (const auto& reduction : reductions) {
+        const std::string& acc = reduction[0];
+        if (reduction[2] != "a + b" || acc == target || acc == over || !isValueLocal(acc)) {
+            return "";
+        }
+        std::vector<Node> expr = toNodes(reduction[1]);
+        std::vector<std::string> lane = {acc};
+        for (const char* offset : {"", " + 1", " + 2", " + 3"}) {
+            lane.push_back(emitFloatExpr(expr, target, over, at + offset, lists));
+            if (lane.back().empty()) {
+                return "";
+            }
+        }
+        lanes.push_back(lane);
+    }
+    std::string code = "{\n";
+    std::string guard;
+    if (over.empty()) {
+        code += "const int64_t " + target + "Stop = " + stop + ";\n";
+        guard = target + "Stop > 0";
+        for (const std::string& list : lists) {
+            guard += " && " + list + ".storage() == PyList::FLOATS && " + list + ".size() >= std::size_t(" + target + "Stop)";
+        }
+    } else {
+        guard = over + ".storage() == PyList::FLOATS";
+    }
+    code += "if (" + guard + ") {\n";
+    code += "const std::size_t " + count + " = " + (over.empty() ? "std::size_t(" + target + "Stop)" : over + ".size()") + ";\n";
+    for (const std::string& list : lists) {
+        code += "const double* __restrict " + list + "Data = " + list + ".floats().data();\n";
+    }
+    for (const auto& lane : lanes) {
+        const std::string& acc = lane[0];
+        code += "double " + acc + "Lane0 = 0, " + acc + "Lane1 = 0, " + acc + "Lane2 = 0, " + acc + "Lane3 = 0;\n";
+    }
+    code += "std::size_t " + at + " = 0;\n";
+    code += "for (; " + at + " + 4 <= " + count + "; " + at + " += 4) {\n";
+    for (const auto& lane : lanes) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            code += lane[0] + "Lane" + std::to_string(k) + " += " + lane[k + 1] + ";\n";
+        }
+    }
+    code += "}\nfor (; " + at + " < " + count + "; ++" + at + ") {\n";
+    for (const auto& lane : lanes) {
+        code += lane[0] + "Lane0 += " + lane[1] + ";\n";
+    }
+    code += "}\n";
+    // An empty loop must leave an int accumulator an int.
+    code += "if (" + count + " > 0) {\n";
+    for (const auto& lane : lanes) {
+        const std::string& acc = lane[0];
+        code += acc + " = " + acc + " + PyValue((" + acc + "Lane0 + " + acc + "Lane1) + (" + acc + "Lane2 + " + acc + "Lane3));\n";
+    }
+    code += "}\n} else {\n" + generic;
+    // Closes the generic loop, the else branch and the hoisting scope.
+    close = "}\n}\n}\n";
+    return code;
+}
+
+// The list comprehension a for clause iterates, if it can be fused into
+// the clause's own comprehension: written inline, or held back in the
+// local the clause names (see FunctionScope::deferred). The source is then
+// never built. Both sides must call only pure functions, since fusing
+// interleaves their evaluation, and the outer side must not mention a name
+// the inner one binds, since the inner loop variables stay in scope.
+bool fusibleSource(const Comprehension& outer, const ComprehensionClause& clause, Comprehension& inner) {
+    if (clause.target.children.size() != 1 || clause.target.children[0].value.empty()) {
+        return false;
+    }
+    std::string text = lineText(clause.tokens);
+    auto deferred = findDeferred(text);
+    std::vector<Node> tokens = toNodes(deferred != currentScope().deferred.end() ? deferred->second : text);
+    std::size_t open = tokens.empty() ? 0 : nextToken(tokens, std::size_t(-1));
+    std::vector<Node> between;
+    std::string rest;
+    if (open >= tokens.size() || tokens[open].value != "["
+        || bracketClose(tokens, open, between, rest) + 1 < tokens.size() || !lineText({Node{rest, {}}}).empty()
+        || !parseComprehension(between, '[', inner)) {
+        return false;
+    }
+    std::set<std::string> bound;
+    std::vector<const std::vector<Node>*> innerParts = {&inner.element};
+    std::vector<const std::vector<Node>*> outerParts = {&outer.key, &outer.element};
+    for (const auto& c : inner.clauses) {
+        targetNames(c.target, bound);
+        innerParts.push_back(&c.tokens);
+    }
+    for (const auto& c : outer.clauses) {
+        if (&c != &clause) {
+            outerParts.push_back(&c.tokens);
+        }
+        std::set<std::string> names;
+        targetNames(c.target, names);
+        for (const auto& name : names) {
+            if (bound.count(name)) {
+                return false;
+            }
+        }
+    }
+    for (const auto* part : innerParts) {
+        if (!callsArePure(*part, "")) {
+            return false;
+        }
+    }
+    for (const auto* part : outerParts) {
+        if (!callsArePure(*part, "")) {
+            return false;
+        }
+        for (const auto& token : *part) {
+            if (bound.count(token.value)) {
+                return false;
+            }
+        }
+    }
+    if (deferred != currentScope().deferred.end()) {
+        currentScope().deferred.erase(deferred);
+    }
+    return true;
+}
+
+// A comprehension becomes one loop nest in a lambda that is called at once,
+// filling a list, set or dict. With a single for and no if, storage is
+// reserved up front from the source's length (range() bounds, or size()
+// of a sized source); a filter leaves the length unknown. A for over
+// another list comprehension runs that one's loops in its place. Returns
+// "" unless the bracket ending tokens[open] opens a comprehension; close is
+// set to the token holding the closing bracket, and whatever follows the
+// bracket there is kept.
+std::string emitComprehension(const std::vector<Node>& tokens, std::size_t open, std::size_t& close) {
+    char bracket = tokens[open].value.back();
+    std::vector<Node> between;
+    std::string rest;
+    close = bracketClose(tokens, open, between, rest);
+    Comprehension comprehension;
+    if (close >= tokens.size() || !parseComprehension(between, bracket, comprehension)) {
+        return "";
+    }
+    std::vector<ComprehensionClause>& clauses = comprehension.clauses;
+    for (std::size_t k = 0; k < clauses.size(); ++k) {
+        Comprehension inner;
+        if (clauses[k].kind == ComprehensionClause::FOR && fusibleSource(comprehension, clauses[k], inner)) {
+            ComprehensionClause bind = {ComprehensionClause::BIND, clauses[k].target, inner.element};
+            inner.clauses.push_back(bind);
+            clauses.erase(clauses.begin() + std::ptrdiff_t(k));
+            clauses.insert(clauses.begin() + std::ptrdiff_t(k), inner.clauses.begin(), inner.clauses.end());
+            --k;
+        }
+    }
+    std::size_t loops = 0;
+    bool filtered = false;
+    for (const auto& clause : clauses) {
+        loops += clause.kind == ComprehensionClause::FOR;
+        filtered = filtered || clause.kind == ComprehensionClause::IF;
+    }
+    bool reserve = loops == 1 && !filtered;
+    std::string type = bracket == '[' ? "PyList" : comprehension.key.empty() ? emitSetType("PyValue") : "PyDict<PyValue, PyValue>";
+    std::string code = "[&] {\n" + type + " items;\n";
+    std::string closing;
+    for (const auto& clause : clauses) {
+        if (clause.kind == ComprehensionClause::IF) {
+            code += "if (pyIsTrue(" + translateExpr(clause.tokens) + ")) {\n";
+            closing += "}\n";
+            continue;
+        }
+        const Node* first = &clause.target;
+        while (first->value.empty() && !first->children.empty()) {
+            first = &first->children[0];
+        }
+        const std::string& name = first->value;
+        if (clause.kind == ComprehensionClause::BIND) {
+            code += "auto " + name + " = " + translateExpr(clause.tokens) + ";\n";
+            continue;
+        }
+        std::size_t callee = clause.tokens.empty() ? 0 : nextToken(clause.tokens, std::size_t(-1));
+        std::vector<std::vector<Node>> args;
+        if (callee + 1 < clause.tokens.size() && clause.tokens[callee].value == "range" && clause.tokens[callee + 1].value[0] == '('
+            && clause.target.children.size() == 1) {
+            args = splitArguments(clause.tokens, callee + 1);
+        }
+        if (args.size() == 1 || args.size() == 2) {
+            std::string from = args.size() == 2 ? emitIndex(args[0]) : "int64_t(0)";
+            code += "const int64_t " + name + "Start = " + from + ", " + name + "Stop = " + emitIndex(args.back()) + ";\n";
+            if (reserve) {
+                code += "items.reserve(" + name + "Stop > " + name + "Start ? std::size_t(" + name + "Stop - " + name + "Start) : 0);\n";
+            }
+            code += "for (int64_t " + name + " = " + name + "Start; " + name + " < " + name + "Stop; ++" + name + ") {\n";
+        } else {
+            std::string unpack;
+            std::string binding = clause.target.children.size() == 1 ? clause.target.children[0].value : emitBinding(clause.target, unpack);
+            code += "auto&& " + name + "Source = " + translateExpr(clause.tokens) + ";\n";
+            if (reserve) {
+                code += "items.reserve(pyLengthHint(" + name + "Source));\n";
+            }
+            code += "for (auto&& " + binding + " : " + name + "Source) {\n" + unpack;
+        }
+        closing += "}\n";
+    }
+    if (bracket == '[') {
+        code += "items.append(" + translateExpr(comprehension.element) + ");\n";
+    } else if (comprehension.key.empty()) {
+        code += "items.insert(" + translateExpr(comprehension.element) + ");\n";
+    } else {
+        // Python evaluates the key first.
+        code += "PyValue itemKey = " + translateExpr(comprehension.key) + ";\n";
+        code += "items.insert(itemKey, " + translateExpr(comprehension.element) + ");\n";
+    }
+    return code + closing + "return items;\n}()" + rest;
+}
+
+// for target in iterable: iterating a generator resumes it in place, so
+// no list of items is built. Tuple targets become structured bindings,
+// nested ones unpacked again in the body, and range() becomes a counted
+// loop with its bound evaluated once. With --parallel-loops, a range loop
+// that is only reductions (and opens no nested block) runs on the thread
+// pool; then no block is opened and bodyStart skips the reductions. Float
+// sums over a list, or over range(n) subscripting lists, get a
+// vectorizable fast path. close is what ends the emitted block.
+std::string emitFor(const Node& node, std::size_t indent, bool hasNestedBlocks, std::string& close, std::size_t& bodyStart) {
+    std::size_t end = headerEnd(node);
+    bodyStart = end + 1;
+    std::vector<Node> target;
+    std::vector<Node> iterable;
+    bool inIterable = false;
+    for (std::size_t i = 0; i <= end && i < node.children.size(); ++i) {
+        if (inIterable) {
+            iterable.push_back(node.children[i]);
+        } else if (node.children[i].value == "in") {
+            inIterable = true;
+        } else {
+            target.push_back(node.children[i]);
+        }
+    }
+    Node pattern = parseTarget(target);
+    std::string unpack;
+    std::string binding = pattern.children.size() == 1 ? pattern.children[0].value : emitBinding(pattern, unpack);
+    std::vector<std::string> targets;
+    for (const auto& target : pattern.children) {
+        targets.push_back(target.value);
+    }
+    if (!iterable.empty()) {
+        std::string& last = iterable.back().value;
+        last.pop_back();
+    }
+    close = "}\n";
+    std::size_t callee = iterable.empty() ? 0 : nextToken(iterable, std::size_t(-1));
+    if (targets.size() == 1 && callee + 1 < iterable.size() && iterable[callee].value == "range"
+        && iterable[callee + 1].value[0] == '(') {
+        std::vector<std::vector<Node>> args = splitArguments(iterable, callee + 1);
+        std::string from = args.size() > 1 ? emitIndex(args[0]) : "int64_t(0)";
+        std::string to = emitIndex(args[args.size() > 1 ? 1 : 0]);
+        const std::string& i = targets[0];
+        if (args.size() == 3) {
+            std::string step = emitIndex(args[2]);
+            return "for (int64_t " + i + " = " + from + ", " + i + "Step = " + step + ", " + i + "Stop = " + to + "; " + i +
+                   "Step > 0 ? " + i + " < " + i + "Stop : " + i + " > " + i + "Stop; " + i + " += " + i + "Step) {\n";
+        }
+        if (codegenOptions().parallelLoops && !hasNestedBlocks) {
+            std::string parallel = emitParallelReductions(node, bodyStart, indent, i, from, to);
+            if (!parallel.empty()) {
+                close.clear();
+                return parallel;
+            }
+            bodyStart = end + 1;
+        }
+        if (args.size() == 1 && !hasNestedBlocks) {
+            std::string generic = "for (int64_t " + i + " = " + from + "; " + i + " < " + i + "Stop; ++" + i + ") {\n";
+            std::string vector = emitVectorLoop(node, bodyStart, indent, i, "", to, generic, close);
+            if (!vector.empty()) {
+                return vector;
+            }
+        }
+        return "for (int64_t " + i + " = " + from + ", " + i + "Stop = " + to + "; " + i + " < " + i + "Stop; ++" + i + ") {\n";
+    }
+    auto source = currentScope().locals.find(lineText(iterable));
+    if (targets.size() == 1 && source != currentScope().locals.end() && !soaElement(source->second).empty()) {
+        // The Ref proxies write p.x += ... through to the columns.
+        currentScope().locals[targets[0]] = soaElement(source->second) + "Ref";
+    }
+    std::string generic = "for (auto&& " + binding + " : " + translateExpr(iterable) + ") {\n" + unpack;
+    if (targets.size() == 1 && !hasNestedBlocks && isListLocal(lineText(iterable))) {
+        std::string vector = emitVectorLoop(node, bodyStart, indent, binding, lineText(iterable), "", generic, close);
+        if (!vector.empty()) {
+            return vector;
+        }
+    }
+    return generic;
+}
+
+std::string generateCode(const Node& node) {
+    std::string code = codegenOptions().strictFloatOrder ? "#define PY_STRICT_FLOAT_ORDER\n" : "";
+    code += runtimeIncludes();
+    std::size_t prologue = code.size();
+    // Each keyword's indentation; one that shares a line with the previous
+    // keyword counts as nested inside it.
+    std::vector<std::size_t> indents;
+    for (std::size_t i = 0; i < node.children.size(); ++i) {
+        std::size_t indent = i == 0 ? 0 : trailingIndent(node.children[i - 1]);
+        bool modifier = i > 0 && node.children[i - 1].value == "async";
+        indents.push_back(indent != std::string::npos ? indent : indents.back() + (modifier ? 0 : 1));
+    }
+    // An async function ends with co_return so it is a coroutine even
+    // without await.
+    BlockStack blocks;
+    for (std::size_t i = 0; i < node.children.size(); ++i) {
+        const Node& child = node.children[i];
+        code += closeBlocks(blocks, indents[i]);
+        bool isAsync = i > 0 && node.children[i - 1].value == "async";
+        if (child.value == "async") {
+            continue;
+        } else if (child.value == "def" && isAsync) {
+            bool value = returnsValue(node, i, indents);
+            code += emitFunction(child, value ? "PyTask<PyValue>" : "PyTask<>");
+            currentScope().uses = countUses(node, i, indents);
+            blocks.push_back({indents[i], value ? "}\n" : "co_return;\n}\n"});
+            code += emitBody(child, headerEnd(child) + 1, blocks);
+        } else if (child.value == "def") {
+            bool generator = isGenerator(node, i, indents);
+            std::string returnType = generator ? "PyGenerator<PyValue>" : returnsValue(node, i, indents) ? "PyValue" : "void";
+            std::string maxsize = i > 0 && !generator ? cacheDecorator(node.children[i - 1]) : "";
+            std::string close = "}\n";
+            // A memoized def writes its cache, so it is never pure.
+            if (maxsize.empty() && isPure(node, i, indents, functionName(child))) {
+                pureFunctions().insert(functionName(child));
+            }
+            code += maxsize.empty() ? emitFunction(child, returnType) : emitCachedFunction(child, returnType, maxsize, close);
+            currentScope().uses = countUses(node, i, indents);
+            blocks.push_back({indents[i], close});
+            code += emitBody(child, headerEnd(child) + 1, blocks);
+        } else if (child.value == "for") {
+            std::string close;
+            std::size_t bodyStart = 0;
+            code += emitFor(child, indents[i], blockEnd(node, i, indents) > i + 1, close, bodyStart);
+            if (!close.empty()) {
+                blocks.push_back({indents[i], close});
+            }
+            code += emitBody(child, bodyStart, blocks);
+        } else if (child.value == "print") {
+            std::size_t end = lineEnd(child);
+            std::vector<Node> expr(child.children.begin(), child.children.begin() + std::ptrdiff_t(end));
+            // Arguments print separated by spaces; the call's parentheses
+            // are not a tuple.
+            code += "std::cout << ";
+            std::string separator;
+            for (const auto& arg : splitArguments(expr, 0)) {
+                if (!lineText(arg).empty()) {
+                    code += separator + "(" + translateExpr(arg) + ") << ";
+                    separator = "\" \" << ";
+                }
+            }
+            code += "std::endl;\n";
+            code += emitBody(child, end, blocks);
+        } else if (child.value == "class") {
+            code += emitStruct(child);
+        } else if (child.value == ":") {
+            code += " {\n";
+        } else if (child.value.empty()) {
+            code += emitBody(child, 0, blocks);
+        } else {
+            code += child.value;
+        }
+    }
+    code += closeBlocks(blocks, 0);
+    if (startsThreads()) {
+        // Threads read module globals that were never handed to them, so
+        // every count is atomic from before main.
+        code.insert(prologue, "const bool pyThreadsEnabled = (pyEnableThreads(), true);\n");
+    }
+    return code;
+}
+
+// The names of TokenType, for JSON dumps.
+const char* tokenTypeName(TokenType type) {
+    static const char* const kNames[] = {"KEYWORD", "IDENTIFIER", "NUMBER", "STRING", "OPERATOR", "WHITESPACE", "UNKNOWN"};
+    return kNames[type];
+}
+
+std::string jsonString(const std::string& value) {
+    std::string json = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (c == '\n') {
+            json += "\\n";
+        } else if (c == '\t') {
+            json += "\\t";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            static const char kHex[] = "0123456789abcdef";
+            json += std::string("\\u00") + kHex[c >> 4] + kHex[c & 15];
+        } else {
+            json += c;
+        }
+    }
+    return json + "\"";
+}
+
+// Dumps tokens one per line, or as a JSON array of {"type", "value"}.
+void printTokens(const std::vector<Token>& tokens, std::ostream& os = std::cout, bool json = false) {
+    if (json) {
+        os << "[";
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            os << (i ? ",\n " : "\n ") << "{\"type\": \"" << tokenTypeName(tokens[i].type)
+               << "\", \"value\": " << jsonString(tokens[i].value) << "}";
+        }
+        os << "\n]" << std::endl;
+        return;
+    }
+    for (const auto& token : tokens) {
+        os << "Token(" << token.value << ", Type: " << token.type << ")" << std::endl;
+    }
+}
+
+void printTreeJson(const Node& node, std::ostream& os, int depth) {
+    os << std::string(depth, ' ') << "{\"value\": " << jsonString(node.value) << ", \"children\": [";
+    for (std::size_t i = 0; i < node.children.size(); ++i) {
+        os << (i ? ",\n" : "\n");
+        printTreeJson(node.children[i], os, depth + 2);
+    }
+    os << (node.children.empty() ? "]}" : "\n" + std::string(depth, ' ') + "]}");
+}
+
+// Dumps the tree indented by depth, or as nested JSON {"value", "children"}.
+void printTree(const Node& node, int depth = 0, std::ostream& os = std::cout, bool json = false) {
+    if (json) {
+        printTreeJson(node, os, depth);
+        os << std::endl;
+        return;
+    }
+    os << std::string(depth, ' ') << node.value << std::endl;
+    for (const auto& child : node.children) {
+        printTree(child, depth + 2, os);
+    }
+}
+
+const int kExitOk = 0;
+// The input could not be read, failed the semantic check, or the output
+// could not be written.
+const int kExitFailed = 1;
+const int kExitUsage = 2;
+
+struct DriverOptions {
+    std::string input;
+    // "-" is stdout.
+    std::string output = "-";
+    // What the output receives: the generated C++ ("cpp"), or the tokens
+    // or syntax tree, in which case the later stages do not run.
+    std::string emit = "cpp";
+    // Token and tree dumps as "text", the menu's format, or "json".
+    std::string format = "text";
+    // Run the semantic check, and fail if it does.
+    bool check = false;
+    bool interactive = false;
+    // input and output are directories: every .py under input is
+    // translated to the same relative path under output.
+    bool batch = false;
+    // Batch and server worker threads; 0 picks one per core.
+    std::size_t jobs = 0;
+    // Unix socket to serve translations on instead of translating input.
+    std::string serve;
+    // Like batch, then retranslate files as they change until SIGTERM.
+    bool watch = false;
+    // Content-addressed translations shared by every run that names it,
+    // and the size it is trimmed back to.
+    std::string cacheDir;
+    std::uintmax_t cacheSize = std::uintmax_t(1) << 30;
+};
+
+void printUsage(std::ostream& os) {
+    os << "Usage: py2cpp [options] INPUT.py [-o OUTPUT]\n"
+          "       py2cpp --batch SRC_DIR -o OUT_DIR [--jobs=N]\n"
+          "       py2cpp --serve=SOCKET [--jobs=N]\n"
+          "       py2cpp --watch SRC_DIR -o OUT_DIR\n"
+          "       py2cpp --interactive\n"
+          "Translates a Python file to C++. INPUT and OUTPUT may be - for stdin/stdout.\n"
+          "  -o, --output=FILE          write to FILE instead of stdout\n"
+          "  --emit=cpp|tokens|tree     what to write; tokens and tree stop before codegen\n"
+          "  --format=text|json         format of a tokens or tree dump\n"
+          "  --check                    run the semantic check and fail if it does\n"
+          "  --parallel-loops           run independent reduction loops on a thread pool\n"
+          "  --parallel-min-trips=N     trip count below which such loops stay serial\n"
+          "  --strict-float-order       add floats in source order\n"
+          "  --batch                    translate every .py under the INPUT directory\n"
+          "  --jobs=N                   batch or server worker threads (default: one per core)\n"
+          "  --serve=SOCKET             translate requests from py2cpp-client until SIGTERM,\n"
+          "                             with the other options applying to every request\n"
+          "  --watch                    like --batch, then retranslate files as they change\n"
+          "  --cache-dir=DIR            reuse translations of identical sources from DIR\n"
+          "  --cache-size=MB            size DIR is trimmed to, least recently used first (1024)\n"
+          "  --interactive              the step-by-step menu\n"
+          "  -h, --help                 show this help\n";
+}
+
+// More workers than this is a typo, not a machine.
+const std::uintmax_t kMaxJobs = 4096;
+
+// Reads the digits matched for a numeric option. Returns false if the
+// value is above limit or too long to read at all.
+bool parseCount(const std::string& digits, std::uintmax_t limit, std::uintmax_t& value) {
+    try {
+        value = std::stoull(digits);
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+    return value <= limit;
+}
+
+// Fills options and codegenOptions() from the command line. Returns false
+// with error set on a malformed one.
+bool parseArguments(int argc, char** argv, DriverOptions& options, std::string& error) {
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        std::smatch match;
+        std::uintmax_t count = 0;
+        if (arg == "-o" || arg == "--output") {
+            if (a + 1 == argc) {
+                error = arg + " needs a file name";
+                return false;
+            }
+            options.output = argv[++a];
+        } else if (arg.rfind("--output=", 0) == 0) {
+            options.output = arg.substr(9);
+        } else if (std::regex_match(arg, match, std::regex("--emit=(cpp|tokens|tree)"))) {
+            options.emit = match[1];
+        } else if (std::regex_match(arg, match, std::regex("--format=(text|json)"))) {
+            options.format = match[1];
+        } else if (arg == "--check") {
+            options.check = true;
+        } else if (arg == "--interactive") {
+            options.interactive = true;
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg.rfind("--cache-dir=", 0) == 0 && arg.size() > 12) {
+            options.cacheDir = arg.substr(12);
+        } else if (std::regex_match(arg, match, std::regex("--cache-size=([0-9]+)"))) {
+            if (!parseCount(match[1], std::numeric_limits<std::uintmax_t>::max() >> 20, count)) {
+                error = "out of range: " + arg;
+                return false;
+            }
+            options.cacheSize = count << 20;
+        } else if (std::regex_match(arg, match, std::regex("--jobs=([0-9]+)"))) {
+            if (!parseCount(match[1], kMaxJobs, count)) {
+                error = "out of range: " + arg + " (at most " + std::to_string(kMaxJobs) + ")";
+                return false;
+            }
+            options.jobs = std::size_t(count);
+        } else if (arg.rfind("--serve=", 0) == 0 && arg.size() > 8) {
+            options.serve = arg.substr(8);
+        } else if (arg == "--parallel-loops") {
+            codegenOptions().parallelLoops = true;
+        } else if (std::regex_match(arg, match, std::regex("--parallel-min-trips=([0-9]+)"))) {
+            if (!parseCount(match[1], std::uintmax_t(std::numeric_limits<long>::max()), count)) {
+                error = "out of range: " + arg;
+                return false;
+            }
+            codegenOptions().minParallelTrips = long(count);
+        } else if (arg == "--strict-float-order") {
+            codegenOptions().strictFloatOrder = true;
+        } else if (arg == "-" || arg[0] != '-') {
+            if (!options.input.empty()) {
+                error = "more than one input: " + options.input + ", " + arg;
+                return false;
+            }
+            options.input = arg;
+        } else {
+            error = "unknown option " + arg;
+            return false;
+        }
+    }
+    if (options.input.empty() && !options.interactive && options.serve.empty()) {
+        error = "no input file";
+        return false;
+    }
+    if ((options.batch || options.watch) && (options.input == "-" || options.output == "-")) {
+        error = std::string(options.watch ? "--watch" : "--batch") + " needs a source directory and -o OUT_DIR";
+        return false;
+    }
+    return true;
+}
+
+// The menu the translator started out with, one stage per choice.
+int runMenu() {
+    std::string filename;
+    std::ifstream file;
+    std::string code;
+    std::vector<Token> tokens;
+    Node syntaxTree;
+    bool exit = false;
+
+    while (!exit) {
+        std::cout << "Menu:\n";
+        std::cout << "1. Load Python file\n";
+        std::cout << "2. Tokenize\n";
+        std::cout << "3. Parse\n";
+        std::cout << "4. Check Semantics\n";
+        std::cout << "5. Generate C++ Code\n";
+        std::cout << "6. Exit\n";
+        std::cout << "Choose an option: ";
+        int option;
+        if (!(std::cin >> option)) {
+            break;
+        }
+
+        switch (option) {
+            case 1:
+                std::cout << "Enter filename: ";
+                std::cin >> filename;
+                file.open(filename);
+                if (file.is_open()) {
+                    code.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                    file.close();
+                    std::cout << "File loaded.\n";
+                } else {
+                    std::cerr << "Failed to open file.\n";
+                }
+                break;
+
+            case 2:
+                if (!code.empty()) {
+                    tokens = tokenize(code);
+                    printTokens(tokens);
+                } else {
+                    std::cerr << "Load a file first.\n";
+                }
+                break;
+
+            case 3:
+                if (!tokens.empty()) {
+                    syntaxTree = parse(tokens);
+                    printTree(syntaxTree);
+                } else {
+                    std::cerr << "Tokenize the code first.\n";
+                }
+                break;
+
+            case 4:
+                if (!syntaxTree.value.empty()) {
+                    if (checkSemantics(syntaxTree)) {
+                        std::cout << "Semantic check passed.\n";
+                    }
+                } else {
+                    std::cerr << "Parse the code first.\n";
+                }
+                break;
+
+            case 5:
+                if (!syntaxTree.value.empty()) {
+                    std::string cppCode = generateCode(syntaxTree);
+                    std::cout << "Generated C++ Code:\n" << cppCode << std::endl;
+                } else {
+                    std::cerr << "Parse the code first.\n";
+                }
+                break;
+
+            case 6:
+                exit = true;
+                break;
+
+            default:
+                std::cerr << "Invalid option.\n";
+                break;
+        }
+    }
+
+    return kExitOk;
+}
+
+// Reads a whole file into code, reusing its capacity.
+bool readSource(const std::filesystem::path& path, std::string& code) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::streamoff size = file.tellg();
+    if (!file || size < 0) {
+        return false;
+    }
+    code.resize(static_cast<std::size_t>(size));
+    file.seekg(0);
+    return bool(file.read(&code[0], static_cast<std::streamsize>(code.size())));
+}
+
+// Two independent 64-bit hashes of data in one pass, eight bytes at a
+// time: together a 128-bit name that identical inputs share and different
+// ones in practice never do.
+std::pair<std::uint64_t, std::uint64_t> hashBytes(const char* data, std::size_t size, std::uint64_t seed) {
+    std::uint64_t a = seed ^ (size * 0x9e3779b97f4a7c15ULL);
+    std::uint64_t b = ~seed ^ (size * 0xc2b2ae3d27d4eb4fULL);
+    auto mix = [&](std::uint64_t word) {
+        a = (a ^ pyMixHash(word)) * 0x9e3779b97f4a7c15ULL;
+        b = (b ^ pyMixHash(word + 0x165667b19e3779f9ULL)) * 0xc2b2ae3d27d4eb4fULL;
+        a = a << 31 | a >> 33;
+        b = b << 29 | b >> 35;
+    };
+    std::size_t at = 0;
+    for (; at + 8 <= size; at += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + at, 8);
+        mix(word);
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data + at, size - at);
+    mix(tail);
+    return {pyMixHash(a), pyMixHash(b ^ a)};
+}
+
+// A hash of this translator's own executable, so a changed translator
+// never trusts what another one left in the cache while identical builds
+// of one source, on any machine, share entries. If the executable cannot
+// be read the version is unique to this process, so nothing is shared.
+const std::string& translatorVersion() {
+    static const std::string version = [] {
+        std::string image;
+        if (!readSource("/proc/self/exe", image) || image.empty()) {
+            return "py2cpp process " + std::to_string(::getpid()) + " "
+                   + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        }
+        auto [h1, h2] = hashBytes(image.data(), image.size(), 0);
+        char name[48];
+        std::snprintf(name, sizeof(name), "py2cpp %016llx%016llx", (unsigned long long)h1, (unsigned long long)h2);
+        return std::string(name);
+    }();
+    return version;
+}
+
+// --cache-dir: translations stored under a hash of the source, the
+// translator version and every option that changes the output, so
+// vendored copies of a file and repeated builds translate it once. Entries
+// are written to a temporary name and renamed into place, which makes
+// concurrent writers (threads or processes) safe: a reader sees a whole
+// entry or none. A hit refreshes the entry's mtime. Once this process
+// has added an eighth of the capacity, and on exit if it added anything,
+// the oldest entries are deleted until the directory is back under it.
+class TranslationCache {
+public:
+    TranslationCache(const std::string& directory, std::uintmax_t capacity) : directory(directory), capacity(capacity) {}
+    ~TranslationCache() {
+        if (pending) {
+            trim();
+        }
+    }
+
+    // The entry name for code translated under options.
+    std::string key(const std::string& code, const DriverOptions& options) const {
+        const CodegenOptions& codegen = codegenOptions();
+        std::string configuration = translatorVersion() + '\n' + options.emit + '\n' + options.format + '\n'
+                                    + char('0' + options.check) + char('0' + codegen.parallelLoops)
+                                    + char('0' + codegen.strictFloatOrder) + std::to_string(codegen.minParallelTrips);
+        auto [h1, h2] = hashBytes(code.data(), code.size(), hashBytes(configuration.data(), configuration.size(), 0).first);
+        char name[33];
+        std::snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long)h1, (unsigned long long)h2);
+        return name;
+    }
+
+    bool find(const std::string& key, std::string& result) {
+        std::filesystem::path entry = pathOf(key);
+        if (!readSource(entry, result)) {
+            ++misses;
+            return false;
+        }
+        std::error_code status;
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), status);
+        ++hits;
+        return true;
+    }
+
+    void store(const std::string& key, const std::string& result) {
+        static std::atomic<unsigned> serial(0);
+        std::filesystem::path entry = pathOf(key);
+        std::filesystem::path temporary = entry;
+        temporary += ".tmp." + std::to_string(::getpid()) + "." + std::to_string(serial++);
+        std::error_code status;
+        std::filesystem::create_directories(entry.parent_path(), status);
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out.write(result.data(), static_cast<std::streamsize>(result.size()));
+            if (!out.flush()) {
+                std::filesystem::remove(temporary, status);
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, entry, status);
+        if (status) {
+            std::filesystem::remove(temporary, status);
+            return;
+        }
+        if ((pending += result.size()) > capacity / 8) {
+            trim();
+        }
+    }
+
+    // "H hits, M misses, E evicted" for the run summaries.
+    std::string statistics() const {
+        std::size_t total = hits + misses;
+        std::ostringstream line;
+        line << "cache " << hits << " hits, " << misses << " misses";
+        if (total) {
+            line << " (" << hits * 100 / total << "% hit)";
+        }
+        if (evicted) {
+            line << ", " << evicted << " evicted";
+        }
+        return line.str();
+    }
+
+private:
+    // Entries fan out over 256 subdirectories by their first two digits.
+    std::filesystem::path pathOf(const std::string& key) const {
+        return std::filesystem::path(directory) / key.substr(0, 2) / key;
+    }
+
+    void trim() {
+        std::unique_lock<std::mutex> guard(trimming, std::try_to_lock);
+        if (!guard) {
+            return;
+        }
+        pending = 0;
+        struct Entry {
+            std::filesystem::file_time_type used;
+            std::uintmax_t size;
+            std::filesystem::path path;
+        };
+        std::vector<Entry> entries;
+        std::uintmax_t total = 0;
+        std::error_code status;
+        for (const auto& file : std::filesystem::recursive_directory_iterator(directory, status)) {
+            if (file.is_regular_file(status) && file.path().filename().string().find('.') == std::string::npos) {
+                entries.push_back({file.last_write_time(status), file.file_size(status), file.path()});
+                total += entries.back().size;
+            }
+        }
+        if (total <= capacity) {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+        for (const Entry& entry : entries) {
+            if (total <= capacity) {
+                break;
+            }
+            if (std::filesystem::remove(entry.path, status)) {
+                ++evicted;
+            }
+            total -= entry.size;
+        }
+    }
+
+    std::string directory;
+    std::uintmax_t capacity;
+    std::atomic<std::uintmax_t> pending{0};
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+    std::atomic<std::size_t> evicted{0};
+    std::mutex trimming;
+};
+
+// The --cache-dir cache, or null without one.
+std::unique_ptr<TranslationCache>& translationCache() {
+    static std::unique_ptr<TranslationCache> cache;
+    return cache;
+}
+
+// Runs the stages up to the one emit asks for on a whole program, leaving
+// their output in result. Returns false if the semantic check rejects it.
+bool runStages(const std::string& code, const DriverOptions& options, std::string& result) {
+    resetTranslationState();
+    bool json = options.format == "json";
+    std::vector<Token> tokens = tokenize(code);
+    if (options.emit == "tokens") {
+        std::ostringstream dump;
+        printTokens(tokens, dump, json);
+        result = dump.str();
+        return true;
+    }
+    Node syntaxTree = parse(tokens);
+    if (options.emit == "tree") {
+        std::ostringstream dump;
+        printTree(syntaxTree, 0, dump, json);
+        result = dump.str();
+        return true;
+    }
+    if (options.check && !checkSemantics(syntaxTree)) {
+        return false;
+    }
+    result = generateCode(syntaxTree);
+    return true;
+}
+
+// runStages, answered from the cache when there is one and it has seen
+// this source under these options. Only successful translations are kept.
+bool translate(const std::string& code, const DriverOptions& options, std::string& result) {
+    TranslationCache* cache = translationCache().get();
+    if (!cache) {
+        return runStages(code, options, result);
+    }
+    std::string key = cache->key(code, options);
+    if (cache->find(key, result)) {
+        return true;
+    }
+    if (!runStages(code, options, result)) {
+        return false;
+    }
+    cache->store(key, result);
+    return true;
+}
+
+// Writes content to path unless the file already holds exactly that, so a
+// build keyed on timestamps does not recompile an unchanged translation.
+// Sets rewritten to whether it wrote; returns false on a write error.
+bool writeIfChanged(const std::filesystem::path& path, const std::string& content, bool& rewritten) {
+    thread_local std::string current;
+    rewritten = false;
+    if (readSource(path, current) && current == content) {
+        return true;
+    }
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary);
+    out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    out.flush();
+    rewritten = true;
+    return bool(out);
+}
+
+struct BatchFile {
+    std::filesystem::path source;
+    std::uintmax_t size;
+};
+
+// Where a batch writes the translation of relative: its path under the
+// output directory, with an extension naming what was emitted.
+std::filesystem::path batchOutputPath(const DriverOptions& options, const std::filesystem::path& relative) {
+    std::filesystem::path target = std::filesystem::path(options.output) / relative;
+    if (options.emit == "cpp") {
+        return target.replace_extension(".cpp");
+    }
+    return target.replace_extension("." + options.emit + (options.format == "json" ? ".json" : ".txt"));
+}
+
+// Translates code, read from source, and writes it to target. Returns ""
+// or the error to report.
+std::string translateTo(const std::filesystem::path& source, const std::string& code,
+                        const std::filesystem::path& target, const DriverOptions& options, std::string& result,
+                        bool& rewritten) {
+    rewritten = false;
+    try {
+        if (!translate(code, options, result)) {
+            return source.string() + " failed the semantic check";
+        } else if (!writeIfChanged(target, result, rewritten)) {
+            return "error writing " + target.string();
+        }
+    } catch (const std::exception& e) {
+        return source.string() + ": " + e.what();
+    }
+    return "";
+}
+
+// The workers --jobs asks for, at most one per item of work.
+std::size_t workerCount(const DriverOptions& options, std::size_t items) {
+    std::size_t jobs = options.jobs ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    return std::min(jobs, std::max<std::size_t>(1, items));
+}
+
+// Calls step(i) for every i below count on jobs workers, each claiming the
+// next index as it finishes one, so work sorted largest first starts the
+// long items early and lets the short ones fill in around them. One job
+// runs on the calling thread.
+void runOnWorkers(std::size_t count, std::size_t jobs, const std::function<void(std::size_t)>& step) {
+    std::atomic<std::size_t> next(0);
+    auto worker = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            step(i);
+        }
+    };
+    if (jobs < 2) {
+        worker();
+        return;
+    }
+    PyThreadPoolExecutor pool(jobs);
+    std::vector<PyFuture<void>> running;
+    for (std::size_t j = 0; j < jobs; ++j) {
+        running.push_back(pool.submit(worker));
+    }
+    for (const auto& future : running) {
+        future.result();
+    }
+}
+
+// Translates every .py under the input directory, largest first on the
+// --jobs workers. Each worker keeps its own translator state and buffers
+// for its whole run.
+int runBatch(const DriverOptions& options) {
+    namespace fs = std::filesystem;
+    std::error_code status;
+    if (!fs::is_directory(options.input, status)) {
+        std::cerr << "py2cpp: " << options.input << " is not a directory" << std::endl;
+        return kExitFailed;
+    }
+    std::vector<BatchFile> files;
+    std::uintmax_t bytes = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(options.input)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".py") {
+            files.push_back({entry.path(), entry.file_size()});
+            bytes += files.back().size;
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const BatchFile& a, const BatchFile& b) {
+        return a.size != b.size ? a.size > b.size : a.source < b.source;
+    });
+
+    std::size_t jobs = workerCount(options, files.size());
+    std::atomic<std::size_t> failed(0);
+    std::mutex report;
+    auto step = [&](std::size_t i) {
+        thread_local std::string code;
+        thread_local std::string result;
+        const fs::path& source = files[i].source;
+        fs::path target = batchOutputPath(options, fs::relative(source, options.input));
+        bool rewritten = false;
+        std::string error = readSource(source, code) ? translateTo(source, code, target, options, result, rewritten)
+                                                     : "cannot open " + source.string();
+        if (!error.empty()) {
+            ++failed;
+            std::lock_guard<std::mutex> guard(report);
+            std::cerr << "py2cpp: " << error << std::endl;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    runOnWorkers(files.size(), jobs, step);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megabytes = bytes / 1e6;
+    std::ostringstream summary;
+    summary.precision(1);
+    summary << std::fixed << "py2cpp: " << files.size() << " files, " << megabytes << " MB in "
+            << seconds << " s on " << jobs << " threads (" << files.size() / std::max(seconds, 1e-9)
+            << " files/s, " << megabytes / std::max(seconds, 1e-9) << " MB/s)";
+    if (failed) {
+        summary << ", " << failed << " failed";
+    }
+    if (translationCache()) {
+        summary << "; " << translationCache()->statistics();
+    }
+    std::cerr << summary.str() << std::endl;
+    return failed ? kExitFailed : kExitOk;
+}
+
+// Server frames are a 4-byte big-endian length and that many bytes. A
+// request is 'P' and a path, or 'S' and the source itself; the reply is
+// '0' and the translation, or '1' and an error message.
+const std::uint32_t kMaxFrame = 1u << 28;
+
+// A worker reading or writing a frame gives up on a client that stalls
+// this long mid-frame, so a partial frame cannot pin a worker or keep the
+// server from stopping.
+const int kFrameTimeoutSeconds = 5;
+
+bool readFrame(int fd, std::string& frame) {
+    unsigned char header[4];
+    for (std::size_t got = 0; got < sizeof(header);) {
+        ssize_t n = ::recv(fd, header + got, sizeof(header) - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    std::uint32_t size = std::uint32_t(header[0]) << 24 | header[1] << 16 | header[2] << 8 | header[3];
+    if (size > kMaxFrame) {
+        return false;
+    }
+    frame.resize(size);
+    for (std::size_t got = 0; got < size;) {
+        ssize_t n = ::recv(fd, &frame[got], size - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+bool writeFrame(int fd, char status, const std::string& body) {
+    std::uint32_t size = body.size() + 1;
+    char header[5] = {char(size >> 24), char(size >> 16), char(size >> 8), char(size), status};
+    for (const auto& [data, length] : {std::pair<const char*, std::size_t>(header, sizeof(header)),
+                                       std::pair<const char*, std::size_t>(body.data(), body.size())}) {
+        for (std::size_t sent = 0; sent < length;) {
+            ssize_t n = ::send(fd, data + sent, length - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+    }
+    return true;
+}
+
+// Translations the server has already made, keyed by source text and
+// evicted least recently used once they hold more than capacity bytes.
+// A build asking again for an unchanged file gets its answer without
+// tokenizing it.
+class ResultCache {
+public:
+    explicit ResultCache(std::size_t capacity) : capacity(capacity) {}
+
+    bool find(const std::string& source, std::string& result) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = index.find(source);
+        if (it == index.end()) {
+            ++misses;
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        result = it->second->second;
+        ++hits;
+        return true;
+    }
+
+    void insert(const std::string& source, const std::string& result) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (index.count(source) || source.size() + result.size() > capacity) {
+            return;
+        }
+        entries.emplace_front(source, result);
+        index.emplace(entries.front().first, entries.begin());
+        bytes += source.size() + result.size();
+        while (bytes > capacity) {
+            auto& [oldSource, oldResult] = entries.back();
+            bytes -= oldSource.size() + oldResult.size();
+            index.erase(oldSource);
+            entries.pop_back();
+        }
+    }
+
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+
+private:
+    using Entry = std::pair<std::string, std::string>;
+    std::mutex lock;
+    std::list<Entry> entries;
+    // Keys view the strings in entries, which a std::list never moves.
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    std::size_t bytes = 0;
+    std::size_t capacity;
+};
+
+// Answers one request on fd. Returns false once the client has hung up.
+bool serveRequest(int fd, const DriverOptions& options, ResultCache& cache) {
+    thread_local std::string request;
+    thread_local std::string code;
+    thread_local std::string result;
+    if (!readFrame(fd, request) || request.empty()) {
+        return false;
+    }
+    if (request[0] == 'P') {
+        if (!readSource(request.substr(1), code)) {
+            return writeFrame(fd, '1', "cannot open " + request.substr(1));
+        }
+    } else if (request[0] == 'S') {
+        code.assign(request, 1, std::string::npos);
+    } else {
+        return writeFrame(fd, '1', "unknown request");
+    }
+    if (cache.find(code, result)) {
+        return writeFrame(fd, '0', result);
+    }
+    try {
+        if (!translate(code, options, result)) {
+            return writeFrame(fd, '1', "failed the semantic check");
+        }
+    } catch (const std::exception& e) {
+        return writeFrame(fd, '1', e.what());
+    }
+    cache.insert(code, result);
+    return writeFrame(fd, '0', result);
+}
+
+// Set from SIGINT/SIGTERM; the handler also writes to the wake pipe of the
+// server or watcher so its poll returns.
+volatile std::sig_atomic_t stopRequested = 0;
+int stopWakeFd = -1;
+
+void requestStop(int) {
+    stopRequested = 1;
+    if (::write(stopWakeFd, "x", 1) < 0) {
+        // Nothing to do: the flag alone stops the next poll round.
+    }
+}
+
+// A long-lived translator on a Unix socket, so small incremental requests
+// skip process startup and find the regexes compiled, the pool running and
+// earlier results cached. The main thread polls the listening socket and
+// the idle connections; a connection with a request waiting goes to a
+// pool worker, which answers that one request and hands the connection
+// back through the wake pipe. An idle client therefore holds no worker,
+// and requests from many clients are answered in parallel.
+int runServer(const DriverOptions& options) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.serve.size() >= sizeof(address.sun_path)) {
+        std::cerr << "py2cpp: socket path too long: " << options.serve << std::endl;
+        return kExitFailed;
+    }
+    std::strcpy(address.sun_path, options.serve.c_str());
+    // A stale socket from an earlier run is replaced; anything else at the
+    // path is left alone.
+    struct stat existing;
+    if (::lstat(options.serve.c_str(), &existing) == 0 && !S_ISSOCK(existing.st_mode)) {
+        std::cerr << "py2cpp: " << options.serve << " exists and is not a socket" << std::endl;
+        return kExitFailed;
+    }
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int wake[2];
+    ::unlink(options.serve.c_str());
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || ::listen(listenFd, SOMAXCONN) < 0 || ::pipe2(wake, O_CLOEXEC | O_NONBLOCK) < 0) {
+        std::cerr << "py2cpp: cannot listen on " << options.serve << ": " << std::strerror(errno) << std::endl;
+        return kExitFailed;
+    }
+    stopWakeFd = wake[1];
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    ResultCache cache(256u << 20);
+    std::mutex lock;
+    std::vector<int> returned;
+    std::vector<int> idle;
+    std::atomic<std::size_t> requests(0);
+    {
+        PyThreadPoolExecutor pool(options.jobs ? options.jobs : std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<pollfd> polled;
+        while (!stopRequested) {
+            polled.assign({{listenFd, POLLIN, 0}, {wake[0], POLLIN, 0}});
+            for (int fd : idle) {
+                polled.push_back({fd, POLLIN, 0});
+            }
+            if (::poll(polled.data(), polled.size(), -1) < 0) {
+                continue;
+            }
+            if (polled[0].revents & POLLIN) {
+                int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd >= 0) {
+                    timeval timeout{kFrameTimeoutSeconds, 0};
+                    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                    idle.push_back(fd);
+                }
+            }
+            if (polled[1].revents & POLLIN) {
+                char drain[64];
+                while (::read(wake[0], drain, sizeof(drain)) > 0) {
+                }
+                std::lock_guard<std::mutex> guard(lock);
+                idle.insert(idle.end(), returned.begin(), returned.end());
+                returned.clear();
+            }
+            for (std::size_t p = 2; p < polled.size(); ++p) {
+                if (!polled[p].revents) {
+                    continue;
+                }
+                int fd = polled[p].fd;
+                idle.erase(std::find(idle.begin(), idle.end(), fd));
+                pool.submit([&, fd] {
+                    if (serveRequest(fd, options, cache)) {
+                        ++requests;
+                        std::lock_guard<std::mutex> guard(lock);
+                        returned.push_back(fd);
+                        if (::write(wake[1], "x", 1) < 0) {
+                            // The pipe is full, so poll is about to wake anyway.
+                        }
+                    } else {
+                        ::close(fd);
+                    }
+                });
+            }
+        }
+    }
+    for (int fd : idle) {
+        ::close(fd);
+    }
+    for (int fd : returned) {
+        ::close(fd);
+    }
+    ::close(listenFd);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    ::unlink(options.serve.c_str());
+    std::cerr << "py2cpp: served " << requests << " requests, " << cache.hits << " from the cache";
+    if (translationCache()) {
+        std::cerr << "; " << translationCache()->statistics();
+    }
+    std::cerr << std::endl;
+    return kExitOk;
+}
+
+// How long a directory must stay quiet before a burst of events (an
+// editor's save, a git checkout) is acted on as one change.
+const int kDebounceMilliseconds = 50;
+
+// A translated source as the watcher last saw it, so an event that leaves
+// the bytes unchanged (a touch, a save without edits, a checkout back to
+// the same content) costs a comparison instead of a translation.
+struct WatchedFile {
+    std::string source;
+    std::string result;
+};
+
+// --watch: translates the tree as --batch does, then follows it with
+// inotify. Events are gathered until the tree has been quiet for
+// kDebounceMilliseconds, and only the .py files they name are read again;
+// those whose bytes changed are retranslated, largest first on the --jobs
+// workers, and their outputs rewritten if the translation differs.
+// Deleting a source deletes its output, even one left from before a
+// failed translation.
+int runWatch(const DriverOptions& options) {
+    namespace fs = std::filesystem;
+    std::error_code status;
+    if (!fs::is_directory(options.input, status)) {
+        std::cerr << "py2cpp: " << options.input << " is not a directory" << std::endl;
+        return kExitFailed;
+    }
+    int notify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int wake[2];
+    if (notify < 0 || ::pipe2(wake, O_CLOEXEC | O_NONBLOCK) < 0) {
+        std::cerr << "py2cpp: cannot watch " << options.input << ": " << std::strerror(errno) << std::endl;
+        return kExitFailed;
+    }
+    stopWakeFd = wake[1];
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::map<int, fs::path> directories;
+    std::map<fs::path, WatchedFile> files;
+    std::set<fs::path> changed;
+    std::set<fs::path> removed;
+    // Watches dir and everything below it, queueing the sources found: a
+    // directory moved or created in the tree can arrive already populated.
+    auto watchTree = [&](const fs::path& root) {
+        const std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+        directories[::inotify_add_watch(notify, root.c_str(), mask)] = root;
+        for (const auto& entry : fs::recursive_directory_iterator(root, status)) {
+            if (entry.is_directory()) {
+                directories[::inotify_add_watch(notify, entry.path().c_str(), mask)] = entry.path();
+            } else if (entry.is_regular_file() && entry.path().extension() == ".py") {
+                changed.insert(entry.path());
+            }
+        }
+    };
+    auto outputOf = [&](const fs::path& source) {
+        return batchOutputPath(options, fs::relative(source, options.input));
+    };
+    // A directory deleted or moved out of the tree: its sources are gone
+    // and so are their outputs, and the watches below it are dropped, since
+    // a moved directory's watches would report under its old path.
+    auto unwatchTree = [&](const fs::path& root) {
+        auto within = [&root](const fs::path& path) {
+            fs::path relative = path.lexically_relative(root);
+            return !relative.empty() && *relative.begin() != "..";
+        };
+        for (const auto& file : files) {
+            if (within(file.first)) {
+                removed.insert(file.first);
+            }
+        }
+        for (auto it = changed.begin(); it != changed.end();) {
+            it = within(*it) ? changed.erase(it) : std::next(it);
+        }
+        for (auto it = directories.begin(); it != directories.end();) {
+            if (within(it->second)) {
+                ::inotify_rm_watch(notify, it->first);
+                it = directories.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    // Brings every queued path up to date. Returns false if any failed.
+    struct Pending {
+        fs::path source;
+        std::string code;
+        std::string result;
+        std::string error;
+        bool rewritten = false;
+    };
+    std::size_t retranslated = 0;
+    std::size_t rewrites = 0;
+    auto update = [&] {
+        bool ok = true;
+        for (const fs::path& source : removed) {
+            if (!changed.count(source) && files.erase(source)) {
+                fs::remove(outputOf(source), status);
+                ++rewrites;
+            }
+        }
+        std::vector<Pending> pending;
+        for (const fs::path& source : changed) {
+            Pending next{source, "", "", "", false};
+            if (!readSource(source, next.code)) {
+                continue;
+            }
+            auto known = files.find(source);
+            if (known == files.end() || known->second.source != next.code || known->second.result.empty()) {
+                pending.push_back(std::move(next));
+            }
+        }
+        std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+            return a.code.size() != b.code.size() ? a.code.size() > b.code.size() : a.source < b.source;
+        });
+        runOnWorkers(pending.size(), workerCount(options, pending.size()), [&](std::size_t i) {
+            Pending& p = pending[i];
+            p.error = translateTo(p.source, p.code, outputOf(p.source), options, p.result, p.rewritten);
+        });
+        for (Pending& p : pending) {
+            ++retranslated;
+            rewrites += p.rewritten;
+            WatchedFile& file = files[p.source];
+            if (p.error.empty()) {
+                file.source.swap(p.code);
+                file.result.swap(p.result);
+            } else {
+                // Keep the entry, so deleting the source still deletes an
+                // output an earlier translation wrote, but with no result,
+                // so the next save is translated even if it restores these
+                // bytes.
+                file = WatchedFile();
+                std::cerr << "py2cpp: " << p.error << std::endl;
+                ok = false;
+            }
+        }
+        changed.clear();
+        removed.clear();
+        return ok;
+    };
+
+    watchTree(options.input);
+    bool ok = update();
+    std::cerr << "py2cpp: watching " << options.input << " (" << files.size() << " files, " << rewrites
+              << " outputs written)" << std::endl;
+
+    alignas(inotify_event) char events[64 * 1024];
+    pollfd polled[2] = {{notify, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    while (!stopRequested) {
+        // Block for the first event of a burst, then keep reading until the
+        // tree has been quiet for the debounce interval.
+        auto first = std::chrono::steady_clock::now();
+        int timeout = -1;
+        while (!stopRequested && ::poll(polled, 2, timeout) > 0 && (polled[0].revents & POLLIN)) {
+            if (timeout < 0) {
+                first = std::chrono::steady_clock::now();
+                timeout = kDebounceMilliseconds;
+            }
+            for (ssize_t n; (n = ::read(notify, events, sizeof(events))) > 0;) {
+                for (char* at = events; at < events + n;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+                    at += sizeof(inotify_event) + event->len;
+                    auto dir = directories.find(event->wd);
+                    if (event->mask & IN_IGNORED) {
+                        directories.erase(event->wd);
+                    }
+                    if (dir == directories.end() || event->len == 0) {
+                        continue;
+                    }
+                    fs::path path = dir->second / event->name;
+                    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                        watchTree(path);
+                    } else if ((event->mask & IN_ISDIR) && (event->mask & (IN_DELETE | IN_MOVED_FROM))) {
+                        unwatchTree(path);
+                    } else if (path.extension() != ".py") {
+                        continue;
+                    } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                        removed.insert(path);
+                        changed.erase(path);
+                    } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                        changed.insert(path);
+                    }
+                }
+            }
+        }
+        if (changed.empty() && removed.empty()) {
+            continue;
+        }
+        std::size_t paths = changed.size() + removed.size();
+        retranslated = 0;
+        rewrites = 0;
+        ok = update() && ok;
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - first).count();
+        std::ostringstream line;
+        line.precision(1);
+        line << std::fixed << "py2cpp: " << paths << " changed, " << retranslated << " retranslated, " << rewrites
+             << " outputs changed, " << milliseconds << " ms from first event (" << kDebounceMilliseconds
+             << " ms debounce)";
+        std::cerr << line.str() << std::endl;
+    }
+    ::close(notify);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    return ok ? kExitOk : kExitFailed;
+}
+
+// One translation with no prompts: runs the stages up to the one emit
+// asks for and writes only its result, diagnostics going to stderr.
+int runDriver(const DriverOptions& options) {
+    std::string code;
+    if (options.input == "-") {
+        code.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else if (!readSource(options.input, code)) {
+        std::cerr << "py2cpp: cannot open " << options.input << std::endl;
+        return kExitFailed;
+    }
+    // Nothing is written on failure, so a build never sees a partial file.
+    std::string result;
+    try {
+        if (!translate(code, options, result)) {
+            return kExitFailed;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "py2cpp: " << options.input << ": " << e.what() << std::endl;
+        return kExitFailed;
+    }
+    std::ofstream file;
+    if (options.output != "-") {
+        file.open(options.output, std::ios::binary);
+    }
+    std::ostream& out = options.output == "-" ? std::cout : file;
+    out << result;
+    out.flush();
+    if (!out) {
+        std::cerr << "py2cpp: error writing " << (options.output == "-" ? "stdout" : options.output) << std::endl;
+        return kExitFailed;
+    }
+    return kExitOk;
+}
+
+int main(int argc, char** argv) {
+    DriverOptions options;
+    std::string error;
+    if (argc == 2 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+        printUsage(std::cout);
+        return kExitOk;
+    }
+    if (!parseArguments(argc, argv, options, error)) {
+        std::cerr << "py2cpp: " << error << "\n";
+        printUsage(std::cerr);
+        return kExitUsage;
+    }
+    if (options.interactive) {
+        return runMenu();
+    }
+    if (!options.cacheDir.empty()) {
+        translationCache() = std::make_unique<TranslationCache>(options.cacheDir, options.cacheSize);
+    }
+    if (!options.serve.empty()) {
+        return runServer(options);
+    }
+    if (options.watch) {
+        return runWatch(options);
+    }
+    return options.batch ? runBatch(options) : runDriver(options);
+}
+```
+
+//**This implementation creates a basic menu-driven application that allows you to:
 
 //**1. Load a Python file
 //**2. Tokenize the code
@@ -1030,6 +4295,111 @@ int main() {
 //**4. Check the semantics
 //**5. Generate equivalent C++ code
 
+//**For builds, run it without the menu: `py2cpp input.py -o output.cpp` (see `py2cpp --help`); `--interactive` brings the menu back.
+
+//**Build systems that translate many small files can keep one translator running with `py2cpp --serve=/tmp/py2cpp.sock` and call this thin client per file instead, which sends the path to the server and writes back what it answers:
+
+//**```cpp
+// py2cpp-client SOCKET INPUT.py [-o OUTPUT]
+// INPUT may be - to send stdin's source instead of a path the server reads.
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+bool sendAll(int fd, const char* data, std::size_t size) {
+    for (std::size_t sent = 0; sent < size;) {
+        ssize_t n = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+bool recvAll(int fd, char* data, std::size_t size) {
+    for (std::size_t got = 0; got < size;) {
+        ssize_t n = ::recv(fd, data + got, size - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string output = "-";
+    if (argc == 5 && std::string(argv[3]) == "-o") {
+        output = argv[4];
+    } else if (argc != 3) {
+        std::cerr << "Usage: py2cpp-client SOCKET INPUT.py [-o OUTPUT]\n";
+        return 2;
+    }
+    // The server has its own working directory, so paths go as absolute.
+    std::string request;
+    if (std::string(argv[2]) == "-") {
+        request = "S";
+        request.append(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        char path[PATH_MAX];
+        if (!::realpath(argv[2], path)) {
+            std::cerr << "py2cpp-client: cannot open " << argv[2] << std::endl;
+            return 1;
+        }
+        request = std::string("P") + path;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "py2cpp-client: no server on " << argv[1] << std::endl;
+        return 1;
+    }
+    std::uint32_t size = request.size();
+    char header[4] = {char(size >> 24), char(size >> 16), char(size >> 8), char(size)};
+    unsigned char reply[4];
+    if (!sendAll(fd, header, 4) || !sendAll(fd, request.data(), request.size())
+        || !recvAll(fd, reinterpret_cast<char*>(reply), 4)) {
+        std::cerr << "py2cpp-client: the server hung up" << std::endl;
+        return 1;
+    }
+    std::string body(std::uint32_t(reply[0]) << 24 | reply[1] << 16 | reply[2] << 8 | reply[3], '\0');
+    if (body.empty() || !recvAll(fd, &body[0], body.size())) {
+        std::cerr << "py2cpp-client: the server hung up" << std::endl;
+        return 1;
+    }
+    ::close(fd);
+    if (body[0] != '0') {
+        std::cerr << "py2cpp-client: " << argv[2] << ": " << body.substr(1) << std::endl;
+        return 1;
+    }
+    std::ofstream file;
+    if (output != "-") {
+        file.open(output, std::ios::binary);
+    }
+    std::ostream& out = output == "-" ? std::cout : file;
+    out.write(body.data() + 1, body.size() - 1);
+    out.flush();
+    if (!out) {
+        std::cerr << "py2cpp-client: error writing " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
+```
+
 //**You can expand and improve each step to handle more Python features and constructs as needed. Have fun coding!
 
 //**Greetings by 
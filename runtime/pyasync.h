@@ -0,0 +1,447 @@
+#ifndef PYASYNC_H
+#define PYASYNC_H
+
+// async def functions become C++20 coroutines returning PyTask, run by a
+// single-threaded epoll event loop. Compiled as C++17 this header is empty.
+#ifdef __cpp_impl_coroutine
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pygenerator.h"
+#include "pyvalue.h"
+
+inline std::runtime_error pyOSError(const char* call) {
+    return std::runtime_error(std::string("OSError: ") + call + ": " + std::strerror(errno));
+}
+
+// One loop per thread, like asyncio's running loop. Ready coroutines run in
+// FIFO order; timers sit in a min-heap; a coroutine waiting on a socket is
+// parked until epoll reports it. Sockets are registered edge-triggered once,
+// on their first wait, so a wait costs no epoll_ctl call.
+class PyEventLoop {
+public:
+    static PyEventLoop& current() {
+        thread_local PyEventLoop loop;
+        return loop;
+    }
+
+    PyEventLoop() : epollFd(epoll_create1(EPOLL_CLOEXEC)) {
+        if (epollFd < 0) {
+            throw pyOSError("epoll_create1");
+        }
+    }
+    ~PyEventLoop() { ::close(epollFd); }
+    PyEventLoop(const PyEventLoop&) = delete;
+    PyEventLoop& operator=(const PyEventLoop&) = delete;
+
+    static double now() {
+        std::chrono::duration<double> t = std::chrono::steady_clock::now().time_since_epoch();
+        return t.count();
+    }
+
+    void schedule(std::coroutine_handle<> coro) { ready.push_back(coro); }
+    void callAt(double when, std::coroutine_handle<> coro) { timers.push({when, nextTimer++, coro}); }
+
+    void waitFd(int fd, bool write, std::coroutine_handle<> coro) {
+        FdWaiters& w = waiters[fd];
+        std::coroutine_handle<>& slot = write ? w.writer : w.reader;
+        if (slot) {
+            throw std::runtime_error("RuntimeError: another coroutine is already waiting on this socket");
+        }
+        slot = coro;
+        ++parked;
+        if (!w.registered) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                throw pyOSError("epoll_ctl");
+            }
+            w.registered = true;
+        }
+    }
+
+    // Must be called before an fd is closed so a reused number starts clean.
+    void forget(int fd) {
+        auto it = waiters.find(fd);
+        if (it != waiters.end()) {
+            parked -= (it->second.reader ? 1 : 0) + (it->second.writer ? 1 : 0);
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            waiters.erase(it);
+        }
+    }
+
+    // Runs until done() holds or nothing is left that could make progress.
+    template <class Done>
+    void runUntil(Done done) {
+        epoll_event events[256];
+        while (!done()) {
+            for (std::size_t n = ready.size(); n > 0 && !ready.empty(); --n) {
+                std::coroutine_handle<> coro = ready.front();
+                ready.pop_front();
+                coro.resume();
+            }
+            if (done()) {
+                break;
+            }
+            // Sockets stay registered after their waiter resumes, so only
+            // a parked coroutine makes an unbounded epoll_wait worthwhile.
+            int timeout = ready.empty() ? timeoutMs() : 0;
+            if (timeout < 0 && parked == 0) {
+                break;
+            }
+            int n = epoll_wait(epollFd, events, 256, timeout);
+            if (n < 0 && errno != EINTR) {
+                throw pyOSError("epoll_wait");
+            }
+            for (int i = 0; i < n; ++i) {
+                wake(events[i].data.fd, events[i].events);
+            }
+            for (double t = now(); !timers.empty() && timers.top().when <= t; timers.pop()) {
+                ready.push_back(timers.top().coro);
+            }
+        }
+    }
+
+private:
+    struct Timer {
+        double when;
+        uint64_t order;
+        std::coroutine_handle<> coro;
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : order > other.order;
+        }
+    };
+    struct FdWaiters {
+        std::coroutine_handle<> reader;
+        std::coroutine_handle<> writer;
+        bool registered = false;
+    };
+
+    int timeoutMs() const {
+        if (timers.empty()) {
+            return -1;
+        }
+        double wait = (timers.top().when - now()) * 1000;
+        return wait <= 0 ? 0 : int(wait) + 1;
+    }
+
+    void wake(int fd, uint32_t ev) {
+        auto it = waiters.find(fd);
+        if (it == waiters.end()) {
+            return;
+        }
+        const uint32_t failed = EPOLLERR | EPOLLHUP;
+        if (it->second.reader && (ev & (EPOLLIN | EPOLLRDHUP | failed))) {
+            ready.push_back(std::exchange(it->second.reader, nullptr));
+            --parked;
+        }
+        if (it->second.writer && (ev & (EPOLLOUT | failed))) {
+            ready.push_back(std::exchange(it->second.writer, nullptr));
+            --parked;
+        }
+    }
+
+    int epollFd;
+    std::deque<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t nextTimer = 0;
+    std::unordered_map<int, FdWaiters> waiters;
+    std::size_t parked = 0;
+};
+
+struct PyTaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    bool detached = false;
+
+    // Finishing hands control straight to the awaiting coroutine, so chains
+    // of awaits do not grow the stack. A detached task frees itself.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coro) noexcept {
+            PyTaskPromiseBase& promise = coro.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            if (promise.detached) {
+                promise.reportDetached();
+                coro.destroy();
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+
+    void reportDetached() noexcept {
+        if (!error) {
+            return;
+        }
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            std::cerr << "Task exception was never retrieved: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Task exception was never retrieved" << std::endl;
+        }
+    }
+
+    static void* operator new(std::size_t size) { return PyFramePool::local().allocate(size); }
+    static void operator delete(void* p, std::size_t size) { PyFramePool::local().release(p, size); }
+};
+
+template <class T>
+struct PyTaskPromise : PyTaskPromiseBase {
+    std::optional<T> value;
+    void return_value(T v) { value = std::move(v); }
+    T result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct PyTaskPromise<void> : PyTaskPromiseBase {
+    void return_void() {}
+    void result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+// A lazily started coroutine. co_await starts it and resumes the awaiting
+// coroutine when it finishes, returning its value or rethrowing.
+template <class T = void>
+class PyTask {
+public:
+    struct promise_type : PyTaskPromise<T> {
+        PyTask get_return_object() { return PyTask(Handle::from_promise(*this)); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    PyTask(PyTask&& other) noexcept : coro(std::exchange(other.coro, nullptr)) {}
+    PyTask& operator=(PyTask other) noexcept {
+        std::swap(coro, other.coro);
+        return *this;
+    }
+    ~PyTask() {
+        if (coro) {
+            coro.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        coro.promise().continuation = awaiting;
+        return coro;
+    }
+    T await_resume() { return coro.promise().result(); }
+
+    bool done() const { return coro.done(); }
+    Handle handle() const { return coro; }
+    Handle release() { return std::exchange(coro, nullptr); }
+
+private:
+    explicit PyTask(Handle coro) : coro(coro) {}
+
+    Handle coro;
+};
+
+// asyncio.run: drives the loop until task finishes and returns its result.
+template <class T>
+T pyRun(PyTask<T> task) {
+    PyEventLoop& loop = PyEventLoop::current();
+    loop.schedule(task.handle());
+    loop.runUntil([&task] { return task.done(); });
+    if (!task.done()) {
+        throw std::runtime_error("RuntimeError: event loop stopped before the task finished");
+    }
+    return task.handle().promise().result();
+}
+
+// asyncio.create_task, fire-and-forget: the task runs concurrently and frees
+// itself when it finishes.
+template <class T>
+void pyCreateTask(PyTask<T> task) {
+    typename PyTask<T>::Handle coro = task.release();
+    coro.promise().detached = true;
+    PyEventLoop::current().schedule(coro);
+}
+
+struct PySleep {
+    double delay;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coro) const {
+        PyEventLoop& loop = PyEventLoop::current();
+        if (delay <= 0) {
+            loop.schedule(coro);
+        } else {
+            loop.callAt(PyEventLoop::now() + delay, coro);
+        }
+    }
+    void await_resume() const noexcept {}
+};
+
+inline PySleep pySleep(double seconds) {
+    return PySleep{seconds};
+}
+
+inline PySleep pySleep(const PyValue& seconds) {
+    return PySleep{seconds.isFloat() ? seconds.asFloat() : double(seconds.asInt())};
+}
+
+struct PyFdWait {
+    int fd;
+    bool write;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coro) const { PyEventLoop::current().waitFd(fd, write, coro); }
+    void await_resume() const noexcept {}
+};
+
+inline PyFdWait pyReadable(int fd) {
+    return PyFdWait{fd, false};
+}
+
+inline PyFdWait pyWritable(int fd) {
+    return PyFdWait{fd, true};
+}
+
+// Socket operations in the style of loop.sock_accept/sock_recv/sock_sendall:
+// each tries the syscall first and only waits when it would block.
+
+inline sockaddr_in pySockAddr(const char* host, int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(port));
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        throw std::invalid_argument(std::string("ValueError: not an IPv4 address: ") + host);
+    }
+    return addr;
+}
+
+inline int pyListenTcp(const char* host, int port, int backlog = 1024) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw pyOSError("socket");
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = pySockAddr(host, port);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, backlog) < 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        throw pyOSError("bind/listen");
+    }
+    return fd;
+}
+
+inline void pyClose(int fd) {
+    PyEventLoop::current().forget(fd);
+    ::close(fd);
+}
+
+inline bool pyWouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+inline PyTask<int> pySockAccept(int listenFd) {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            co_return fd;
+        }
+        if (errno != EINTR && !pyWouldBlock()) {
+            throw pyOSError("accept");
+        }
+        co_await pyReadable(listenFd);
+    }
+}
+
+inline PyTask<int> pySockConnect(const char* host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw pyOSError("socket");
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    sockaddr_in addr = pySockAddr(host, port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        if (errno != EINPROGRESS) {
+            ::close(fd);
+            throw pyOSError("connect");
+        }
+        co_await pyWritable(fd);
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error != 0) {
+            pyClose(fd);
+            errno = error;
+            throw pyOSError("connect");
+        }
+    }
+    co_return fd;
+}
+
+// Returns 0 at end of stream.
+inline PyTask<std::size_t> pySockRecv(int fd, char* buf, std::size_t n) {
+    for (;;) {
+        ssize_t got = ::recv(fd, buf, n, 0);
+        if (got >= 0) {
+            co_return std::size_t(got);
+        }
+        if (errno != EINTR && !pyWouldBlock()) {
+            throw pyOSError("recv");
+        }
+        co_await pyReadable(fd);
+    }
+}
+
+inline PyTask<> pySockSendAll(int fd, const char* data, std::size_t n) {
+    while (n > 0) {
+        ssize_t sent = ::send(fd, data, n, MSG_NOSIGNAL);
+        if (sent >= 0) {
+            data += sent;
+            n -= std::size_t(sent);
+        } else if (errno != EINTR && !pyWouldBlock()) {
+            throw pyOSError("send");
+        } else if (errno != EINTR) {
+            co_await pyWritable(fd);
+        }
+    }
+}
+
+#endif // __cpp_impl_coroutine
+
+#endif // PYASYNC_H
@@ -0,0 +1,252 @@
+#ifndef PYDICT_H
+#define PYDICT_H
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "pyhash.h"
+
+// Defined in pytuple.h, which includes this header through pystr.h; the
+// overloads for PyValue and PyStr are found when the repr is instantiated.
+template <class T>
+void pyRepr(std::ostream& os, const T& value);
+
+// Insertion-ordered dict laid out like CPython's compact dict: entries are
+// appended to a dense array, and a separate open-addressed table of small
+// integers (1, 2 or 4 bytes wide) maps hash slots to entry positions.
+template <class K, class V, class Hash = PyHash<K>>
+class PyDict {
+public:
+    struct Entry {
+        uint64_t hash;
+        K key;
+        V value;
+        bool live;
+    };
+
+    class iterator {
+    public:
+        iterator(Entry* pos, Entry* end) : pos(pos), end(end) { skipDead(); }
+        std::pair<const K&, V&> operator*() const { return {pos->key, pos->value}; }
+        iterator& operator++() {
+            ++pos;
+            skipDead();
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+        bool operator==(const iterator& other) const { return pos == other.pos; }
+
+    private:
+        void skipDead() {
+            while (pos != end && !pos->live) {
+                ++pos;
+            }
+        }
+        Entry* pos;
+        Entry* end;
+    };
+
+    PyDict() { rebuild(kMinCapacity); }
+
+    std::size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+
+    iterator begin() { return iterator(entries.data(), entries.data() + entries.size()); }
+    iterator end() {
+        Entry* last = entries.data() + entries.size();
+        return iterator(last, last);
+    }
+
+    void reserve(std::size_t n) {
+        if (n > usable()) {
+            rebuild(capacityFor(n));
+        }
+    }
+
+    template <class Q>
+    V* find(const Q& key) {
+        int64_t ix = lookup(key, Hash()(key)).second;
+        return ix >= 0 ? &entries[ix].value : nullptr;
+    }
+    template <class Q>
+    const V* find(const Q& key) const {
+        return const_cast<PyDict*>(this)->find(key);
+    }
+    template <class Q>
+    bool contains(const Q& key) const { return find(key) != nullptr; }
+
+    template <class Q>
+    const V& at(const Q& key) const {
+        if (const V* v = find(key)) {
+            return *v;
+        }
+        throw std::out_of_range("KeyError");
+    }
+    template <class Q>
+    V get(const Q& key, V fallback) const {
+        const V* v = find(key);
+        return v ? *v : fallback;
+    }
+
+    V& operator[](const K& key) {
+        uint64_t hash = Hash()(key);
+        auto [slot, ix] = lookup(key, hash);
+        if (ix >= 0) {
+            return entries[ix].value;
+        }
+        if (entries.size() >= usable()) {
+            rebuild(capacityFor(used + 1));
+            slot = emptySlot(hash);
+        }
+        setIndex(slot, int64_t(entries.size()));
+        entries.push_back({hash, key, V(), true});
+        ++used;
+        return entries.back().value;
+    }
+
+    void insert(const K& key, V value) { (*this)[key] = std::move(value); }
+
+    template <class Q>
+    bool erase(const Q& key) {
+        auto [slot, ix] = lookup(key, Hash()(key));
+        if (ix < 0) {
+            return false;
+        }
+        setIndex(slot, DUMMY);
+        entries[ix].live = false;
+        entries[ix].value = V();
+        --used;
+        return true;
+    }
+
+    void clear() {
+        entries.clear();
+        used = 0;
+        rebuild(kMinCapacity);
+    }
+
+    // Python's repr, {key: value, ...}, in insertion order.
+    friend std::ostream& operator<<(std::ostream& os, const PyDict& dict) {
+        os << '{';
+        bool first = true;
+        for (const Entry& entry : dict.entries) {
+            if (entry.live) {
+                os << (first ? "" : ", ");
+                pyRepr(os, entry.key);
+                os << ": ";
+                pyRepr(os, entry.value);
+                first = false;
+            }
+        }
+        return os << '}';
+    }
+
+private:
+    static constexpr int64_t EMPTY = -1;
+    static constexpr int64_t DUMMY = -2;
+    static constexpr std::size_t kMinCapacity = 8;
+
+    std::size_t usable() const { return capacity * 2 / 3; }
+
+    static std::size_t capacityFor(std::size_t n) {
+        std::size_t cap = kMinCapacity;
+        while (cap * 2 / 3 < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    int64_t getIndex(std::size_t slot) const {
+        switch (width) {
+            case 1: return reinterpret_cast<const int8_t*>(indices.data())[slot];
+            case 2: return reinterpret_cast<const int16_t*>(indices.data())[slot];
+            default: return reinterpret_cast<const int32_t*>(indices.data())[slot];
+        }
+    }
+    void setIndex(std::size_t slot, int64_t ix) {
+        switch (width) {
+            case 1: reinterpret_cast<int8_t*>(indices.data())[slot] = int8_t(ix); break;
+            case 2: reinterpret_cast<int16_t*>(indices.data())[slot] = int16_t(ix); break;
+            default: reinterpret_cast<int32_t*>(indices.data())[slot] = int32_t(ix); break;
+        }
+    }
+
+    // Returns the slot holding the key and its entry position, or the first
+    // reusable slot and -1 when the key is absent.
+    template <class Q>
+    std::pair<std::size_t, int64_t> lookup(const Q& key, uint64_t hash) const {
+        std::size_t mask = capacity - 1;
+        std::size_t slot = hash & mask;
+        uint64_t perturb = hash;
+        std::size_t freeSlot = SIZE_MAX;
+        while (true) {
+            int64_t ix = getIndex(slot);
+            if (ix == EMPTY) {
+                return {freeSlot != SIZE_MAX ? freeSlot : slot, -1};
+            }
+            if (ix == DUMMY) {
+                if (freeSlot == SIZE_MAX) {
+                    freeSlot = slot;
+                }
+            } else {
+                const Entry& e = entries[ix];
+                if (e.hash == hash && e.key == key) {
+                    return {slot, ix};
+                }
+            }
+            perturb >>= 5;
+            slot = (slot * 5 + perturb + 1) & mask;
+        }
+    }
+
+    std::size_t emptySlot(uint64_t hash) const {
+        std::size_t mask = capacity - 1;
+        std::size_t slot = hash & mask;
+        uint64_t perturb = hash;
+        while (getIndex(slot) != EMPTY) {
+            perturb >>= 5;
+            slot = (slot * 5 + perturb + 1) & mask;
+        }
+        return slot;
+    }
+
+    // Resizes the index table and compacts deleted entries out of the
+    // dense array, keeping insertion order.
+    void rebuild(std::size_t newCapacity) {
+        capacity = newCapacity;
+        width = capacity <= 128 ? 1 : capacity <= 32768 ? 2 : 4;
+        indices.assign(capacity * width, 0xFF);
+        if (used != entries.size()) {
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].live) {
+                    if (out != i) {
+                        entries[out] = std::move(entries[i]);
+                    }
+                    ++out;
+                }
+            }
+            entries.erase(entries.begin() + out, entries.end());
+        }
+        entries.reserve(usable());
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            setIndex(emptySlot(entries[i].hash), int64_t(i));
+        }
+    }
+
+    std::vector<Entry> entries;
+    std::vector<uint8_t> indices;
+    std::size_t capacity = 0;
+    std::size_t width = 1;
+    std::size_t used = 0;
+};
+
+template <class K, class V, class H, class Q>
+bool pyContains(const PyDict<K, V, H>& dict, const Q& key) {
+    return dict.contains(key);
+}
+
+#endif // PYDICT_H
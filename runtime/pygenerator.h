@@ -0,0 +1,144 @@
+#ifndef PYGENERATOR_H
+#define PYGENERATOR_H
+
+// Generator functions become stackless C++20 coroutines. Compiled as C++17
+// this header is empty, so it can be included unconditionally.
+#ifdef __cpp_impl_coroutine
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Recycles coroutine frames per thread. Frames are bucketed into 64-byte
+// size classes; a finished generator's frame goes on its class's free list
+// and the next call of similar size reuses it, so calling a generator in a
+// loop touches the heap only the first time. Like PyArena, the pool is
+// never returned to the system.
+class PyFramePool {
+public:
+    static const std::size_t GRANULE = 64;
+    static const std::size_t CLASSES = 32;
+
+    static PyFramePool& local() {
+        thread_local PyFramePool* pool = new PyFramePool();
+        return *pool;
+    }
+
+    void* allocate(std::size_t size) {
+        std::size_t c = classOf(size);
+        if (c >= CLASSES) {
+            return ::operator new(size);
+        }
+        if (FreeFrame* frame = free[c]) {
+            free[c] = frame->next;
+            return frame;
+        }
+        return ::operator new((c + 1) * GRANULE);
+    }
+
+    void release(void* p, std::size_t size) {
+        std::size_t c = classOf(size);
+        if (c >= CLASSES) {
+            ::operator delete(p);
+            return;
+        }
+        FreeFrame* frame = static_cast<FreeFrame*>(p);
+        frame->next = free[c];
+        free[c] = frame;
+    }
+
+private:
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+
+    static std::size_t classOf(std::size_t size) { return (size + GRANULE - 1) / GRANULE - 1; }
+
+    FreeFrame* free[CLASSES] = {};
+};
+
+// The value type of a generator function. Yielded values are not copied:
+// the promise keeps a pointer to the operand of co_yield, which lives in the
+// frame until the generator resumes, so iterating costs no allocation per
+// item. When the generator is created and consumed in one scope, compilers
+// that implement heap allocation elision (clang at -O2) drop the frame
+// allocation entirely; otherwise it comes from PyFramePool.
+template <class T>
+class PyGenerator {
+public:
+    struct promise_type {
+        const T* current = nullptr;
+        std::exception_ptr error;
+
+        PyGenerator get_return_object() { return PyGenerator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { error = std::current_exception(); }
+
+        static void* operator new(std::size_t size) { return PyFramePool::local().allocate(size); }
+        static void operator delete(void* p, std::size_t size) { PyFramePool::local().release(p, size); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        explicit iterator(Handle coro) : coro(coro) {}
+        const T& operator*() const { return *coro.promise().current; }
+        iterator& operator++() {
+            advance(coro);
+            return *this;
+        }
+        bool operator==(std::default_sentinel_t) const { return !coro || coro.done(); }
+        bool operator!=(std::default_sentinel_t end) const { return !(*this == end); }
+
+    private:
+        Handle coro;
+    };
+
+    PyGenerator(PyGenerator&& other) noexcept : coro(std::exchange(other.coro, nullptr)) {}
+    PyGenerator& operator=(PyGenerator other) noexcept {
+        std::swap(coro, other.coro);
+        return *this;
+    }
+    ~PyGenerator() {
+        if (coro) {
+            coro.destroy();
+        }
+    }
+
+    // Like a Python generator, this is single-pass: a second loop picks up
+    // after the last item the first one consumed.
+    iterator begin() {
+        if (coro && !coro.done()) {
+            advance(coro);
+        }
+        return iterator(coro);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    explicit PyGenerator(Handle coro) : coro(coro) {}
+
+    static void advance(Handle coro) {
+        coro.resume();
+        if (coro.done() && coro.promise().error) {
+            std::rethrow_exception(coro.promise().error);
+        }
+    }
+
+    Handle coro;
+};
+
+#endif // __cpp_impl_coroutine
+
+#endif // PYGENERATOR_H
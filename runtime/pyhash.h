@@ -0,0 +1,35 @@
+#ifndef PYHASH_H
+#define PYHASH_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Hashes used by the runtime containers. Ints hash to themselves like in
+// CPython; containers that need well-mixed bits run them through pyMixHash.
+// Strings hash through string_view so lookups by literal never build a
+// std::string.
+template <class K>
+struct PyHash {
+    uint64_t operator()(const K& key) const { return std::hash<K>()(key); }
+};
+
+template <>
+struct PyHash<int64_t> {
+    uint64_t operator()(int64_t key) const { return uint64_t(key); }
+};
+
+template <>
+struct PyHash<std::string> {
+    uint64_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+
+inline uint64_t pyMixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#endif // PYHASH_H
@@ -0,0 +1,543 @@
+#ifndef PYINT_H
+#define PYINT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pyhash.h"
+#include "pyobject.h"
+
+// Unbounded Python int. Values that fit in int64 are stored inline and every
+// operation first tries the inline path with an overflow-checked builtin;
+// only results that leave int64 are promoted to a heap magnitude of 32-bit
+// limbs, least significant first.
+
+typedef std::vector<uint32_t> PyMag;
+
+struct PyBigLimbs : PyObject {
+    PyBigLimbs(bool negative, PyMag mag) : negative(negative), mag(std::move(mag)) {}
+    bool negative;
+    PyMag mag;
+};
+
+class PyInt {
+public:
+    static constexpr std::size_t KARATSUBA_THRESHOLD = 48;
+    static constexpr std::size_t STR_SPLIT_THRESHOLD = 32;
+
+    PyInt() : small(0), big(nullptr) {}
+    PyInt(int v) : small(v), big(nullptr) {}
+    PyInt(int64_t v) : small(v), big(nullptr) {}
+    PyInt(const PyInt& other) : small(other.small), big(other.big) {
+        if (big) {
+            pyIncRef(big);
+        }
+    }
+    PyInt(PyInt&& other) noexcept : small(other.small), big(other.big) { other.big = nullptr; }
+    PyInt& operator=(PyInt other) noexcept {
+        std::swap(small, other.small);
+        std::swap(big, other.big);
+        return *this;
+    }
+    ~PyInt() {
+        if (big) {
+            pyDecRef(big);
+        }
+    }
+
+    static PyInt fromString(std::string_view digits) {
+        bool negative = !digits.empty() && digits[0] == '-';
+        if (negative || (!digits.empty() && digits[0] == '+')) {
+            digits.remove_prefix(1);
+        }
+        if (digits.empty()) {
+            throw std::invalid_argument("ValueError: invalid literal for int()");
+        }
+        PyMag mag;
+        std::size_t first = digits.size() % 9 == 0 ? 9 : digits.size() % 9;
+        for (std::size_t pos = 0; pos < digits.size(); pos = pos == 0 ? first : pos + 9) {
+            std::size_t len = pos == 0 ? first : 9;
+            uint32_t chunk = 0;
+            uint32_t scale = 1;
+            for (char c : digits.substr(pos, len)) {
+                if (c < '0' || c > '9') {
+                    throw std::invalid_argument("ValueError: invalid literal for int()");
+                }
+                chunk = chunk * 10 + uint32_t(c - '0');
+                scale *= 10;
+            }
+            mulSmallAdd(mag, scale, chunk);
+        }
+        return fromMag(negative, std::move(mag));
+    }
+
+    // Truncates toward zero, like int(x).
+    static PyInt fromDouble(double d) {
+        if (std::isnan(d) || std::isinf(d)) {
+            throw std::overflow_error("OverflowError: cannot convert float to integer");
+        }
+        d = std::trunc(d);
+        if (d >= -9.2e18 && d <= 9.2e18) {
+            return PyInt(int64_t(d));
+        }
+        int exp;
+        double frac = std::frexp(std::fabs(d), &exp);
+        PyMag mag = toMag(int64_t(std::ldexp(frac, 53)));
+        shiftLeft(mag, std::size_t(exp - 53));
+        return fromMag(d < 0, std::move(mag));
+    }
+
+    bool isSmall() const { return big == nullptr; }
+    void share() const { pyShare(big); }
+    bool isNegative() const { return big ? big->negative : small < 0; }
+
+    int64_t toInt64() const {
+        if (big) {
+            throw std::overflow_error("OverflowError: int too large to convert");
+        }
+        return small;
+    }
+    double toDouble() const {
+        if (!big) {
+            return double(small);
+        }
+        double d = 0.0;
+        for (std::size_t i = big->mag.size(); i-- > 0;) {
+            d = d * 4294967296.0 + big->mag[i];
+        }
+        return big->negative ? -d : d;
+    }
+
+    uint64_t hash() const {
+        if (!big) {
+            return uint64_t(small);
+        }
+        uint64_t h = big->negative ? 1 : 0;
+        for (uint32_t limb : big->mag) {
+            h = pyMixHash(h ^ limb);
+        }
+        return h;
+    }
+
+    std::string str() const {
+        if (!big) {
+            return std::to_string(small);
+        }
+        // Squares of 10^9 let long values split in halves instead of
+        // paying one pass over the limbs for every nine digits.
+        std::vector<PyMag> powers{PyMag{1000000000}};
+        while (2 * powers.back().size() <= big->mag.size()) {
+            powers.push_back(mul(powers.back(), powers.back()));
+        }
+        std::string s = big->negative ? "-" : "";
+        appendDigits(big->mag, 0, powers, s);
+        return s;
+    }
+    friend std::ostream& operator<<(std::ostream& os, const PyInt& v) {
+        return os << v.str();
+    }
+
+    friend PyInt operator+(const PyInt& a, const PyInt& b) {
+        int64_t r;
+        if (!a.big && !b.big && !__builtin_add_overflow(a.small, b.small, &r)) {
+            return PyInt(r);
+        }
+        return addSigned(a.sign(), a.mag(), b.sign(), b.mag());
+    }
+    friend PyInt operator-(const PyInt& a, const PyInt& b) {
+        int64_t r;
+        if (!a.big && !b.big && !__builtin_sub_overflow(a.small, b.small, &r)) {
+            return PyInt(r);
+        }
+        return addSigned(a.sign(), a.mag(), !b.sign(), b.mag());
+    }
+    friend PyInt operator*(const PyInt& a, const PyInt& b) {
+        int64_t r;
+        if (!a.big && !b.big && !__builtin_mul_overflow(a.small, b.small, &r)) {
+            return PyInt(r);
+        }
+        return fromMag(a.sign() != b.sign(), mul(a.mag(), b.mag()));
+    }
+    PyInt operator-() const { return PyInt() - *this; }
+
+    // Python floor division and modulo: the remainder takes the divisor's sign.
+    friend PyInt floorDiv(const PyInt& a, const PyInt& b) {
+        PyInt q, r;
+        divmod(a, b, q, r);
+        return q;
+    }
+    friend PyInt operator%(const PyInt& a, const PyInt& b) {
+        PyInt q, r;
+        divmod(a, b, q, r);
+        return r;
+    }
+    friend void divmod(const PyInt& a, const PyInt& b, PyInt& q, PyInt& r) {
+        if (b.isZero()) {
+            throw std::domain_error("ZeroDivisionError: integer division or modulo by zero");
+        }
+        if (!a.big && !b.big && !(a.small == INT64_MIN && b.small == -1)) {
+            int64_t quot = a.small / b.small;
+            int64_t rem = a.small % b.small;
+            if (rem != 0 && ((rem < 0) != (b.small < 0))) {
+                --quot;
+                rem += b.small;
+            }
+            q = PyInt(quot);
+            r = PyInt(rem);
+            return;
+        }
+        PyMag quot, rem;
+        divMag(a.mag(), b.mag(), quot, rem);
+        q = fromMag(a.sign() != b.sign(), std::move(quot));
+        r = fromMag(a.sign(), std::move(rem));
+        if (!r.isZero() && r.isNegative() != b.isNegative()) {
+            q = q - PyInt(1);
+            r = r + b;
+        }
+    }
+
+    friend PyInt pow(PyInt base, uint64_t exp) {
+        PyInt result(1);
+        while (exp != 0) {
+            if (exp & 1) {
+                result = result * base;
+            }
+            exp >>= 1;
+            if (exp != 0) {
+                base = base * base;
+            }
+        }
+        return result;
+    }
+
+    friend int compare(const PyInt& a, const PyInt& b) {
+        if (!a.big && !b.big) {
+            return a.small < b.small ? -1 : a.small > b.small ? 1 : 0;
+        }
+        if (a.sign() != b.sign()) {
+            return a.sign() ? -1 : 1;
+        }
+        int c = cmpMag(a.mag(), b.mag());
+        return a.sign() ? -c : c;
+    }
+    friend bool operator==(const PyInt& a, const PyInt& b) { return compare(a, b) == 0; }
+    friend bool operator!=(const PyInt& a, const PyInt& b) { return compare(a, b) != 0; }
+    friend bool operator<(const PyInt& a, const PyInt& b) { return compare(a, b) < 0; }
+    friend bool operator<=(const PyInt& a, const PyInt& b) { return compare(a, b) <= 0; }
+    friend bool operator>(const PyInt& a, const PyInt& b) { return compare(a, b) > 0; }
+    friend bool operator>=(const PyInt& a, const PyInt& b) { return compare(a, b) >= 0; }
+
+private:
+    bool isZero() const { return !big && small == 0; }
+    bool sign() const { return isNegative(); }
+    PyMag mag() const { return big ? big->mag : toMag(small); }
+
+    static PyMag toMag(int64_t v) {
+        uint64_t m = v < 0 ? uint64_t(-(v + 1)) + 1 : uint64_t(v);
+        PyMag mag;
+        while (m != 0) {
+            mag.push_back(uint32_t(m));
+            m >>= 32;
+        }
+        return mag;
+    }
+
+    static void trim(PyMag& mag) {
+        while (!mag.empty() && mag.back() == 0) {
+            mag.pop_back();
+        }
+    }
+
+    // Demotes to the inline form whenever the value fits in int64.
+    static PyInt fromMag(bool negative, PyMag mag) {
+        trim(mag);
+        if (mag.size() <= 2) {
+            uint64_t m = mag.empty() ? 0 : mag[0];
+            if (mag.size() == 2) {
+                m |= uint64_t(mag[1]) << 32;
+            }
+            if (m <= uint64_t(INT64_MAX)) {
+                return PyInt(negative ? -int64_t(m) : int64_t(m));
+            }
+            if (negative && m == uint64_t(INT64_MAX) + 1) {
+                return PyInt(INT64_MIN);
+            }
+        }
+        PyInt result;
+        result.big = new PyBigLimbs(negative, std::move(mag));
+        return result;
+    }
+
+    static int cmpMag(const PyMag& a, const PyMag& b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size() ? -1 : 1;
+        }
+        for (std::size_t i = a.size(); i-- > 0;) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    static PyMag addMag(const PyMag& a, const PyMag& b) {
+        const PyMag& longer = a.size() >= b.size() ? a : b;
+        const PyMag& shorter = a.size() >= b.size() ? b : a;
+        PyMag r(longer.size() + 1);
+        uint64_t carry = 0;
+        for (std::size_t i = 0; i < longer.size(); ++i) {
+            carry += uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0);
+            r[i] = uint32_t(carry);
+            carry >>= 32;
+        }
+        r[longer.size()] = uint32_t(carry);
+        trim(r);
+        return r;
+    }
+
+    // Requires a >= b.
+    static PyMag subMag(const PyMag& a, const PyMag& b) {
+        PyMag r(a.size());
+        int64_t borrow = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            int64_t d = int64_t(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+            borrow = d < 0 ? 1 : 0;
+            r[i] = uint32_t(d + (borrow << 32));
+        }
+        trim(r);
+        return r;
+    }
+
+    static PyInt addSigned(bool aNeg, const PyMag& a, bool bNeg, const PyMag& b) {
+        if (aNeg == bNeg) {
+            return fromMag(aNeg, addMag(a, b));
+        }
+        if (cmpMag(a, b) >= 0) {
+            return fromMag(aNeg, subMag(a, b));
+        }
+        return fromMag(bNeg, subMag(b, a));
+    }
+
+    static PyMag mulSchool(const PyMag& a, const PyMag& b) {
+        if (a.empty() || b.empty()) {
+            return PyMag();
+        }
+        PyMag r(a.size() + b.size());
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            uint64_t carry = 0;
+            for (std::size_t j = 0; j < b.size(); ++j) {
+                carry += uint64_t(a[i]) * b[j] + r[i + j];
+                r[i + j] = uint32_t(carry);
+                carry >>= 32;
+            }
+            r[i + b.size()] = uint32_t(carry);
+        }
+        trim(r);
+        return r;
+    }
+
+    static PyMag slice(const PyMag& a, std::size_t from, std::size_t to) {
+        from = std::min(from, a.size());
+        to = std::min(to, a.size());
+        PyMag r(a.begin() + from, a.begin() + to);
+        trim(r);
+        return r;
+    }
+
+    static void addShifted(PyMag& acc, const PyMag& x, std::size_t limbs) {
+        if (acc.size() < x.size() + limbs + 1) {
+            acc.resize(x.size() + limbs + 1);
+        }
+        uint64_t carry = 0;
+        std::size_t i = 0;
+        for (; i < x.size(); ++i) {
+            carry += uint64_t(acc[i + limbs]) + x[i];
+            acc[i + limbs] = uint32_t(carry);
+            carry >>= 32;
+        }
+        for (; carry != 0; ++i) {
+            if (i + limbs == acc.size()) {
+                acc.push_back(0);
+            }
+            carry += acc[i + limbs];
+            acc[i + limbs] = uint32_t(carry);
+            carry >>= 32;
+        }
+    }
+
+    // Karatsuba above the threshold, schoolbook below it.
+    static PyMag mul(const PyMag& a, const PyMag& b) {
+        if (std::min(a.size(), b.size()) < KARATSUBA_THRESHOLD) {
+            return mulSchool(a, b);
+        }
+        std::size_t half = std::max(a.size(), b.size()) / 2;
+        PyMag a0 = slice(a, 0, half), a1 = slice(a, half, a.size());
+        PyMag b0 = slice(b, 0, half), b1 = slice(b, half, b.size());
+        PyMag z0 = mul(a0, b0);
+        PyMag z2 = mul(a1, b1);
+        PyMag z1 = subMag(subMag(mul(addMag(a0, a1), addMag(b0, b1)), z0), z2);
+        PyMag r = z0;
+        addShifted(r, z1, half);
+        addShifted(r, z2, 2 * half);
+        trim(r);
+        return r;
+    }
+
+    static void mulSmallAdd(PyMag& mag, uint32_t m, uint32_t add) {
+        uint64_t carry = add;
+        for (uint32_t& limb : mag) {
+            carry += uint64_t(limb) * m;
+            limb = uint32_t(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) {
+            mag.push_back(uint32_t(carry));
+        }
+    }
+
+    // Divides in place and returns the remainder.
+    static uint32_t divSmall(PyMag& mag, uint32_t d) {
+        uint64_t rem = 0;
+        for (std::size_t i = mag.size(); i-- > 0;) {
+            uint64_t cur = (rem << 32) | mag[i];
+            mag[i] = uint32_t(cur / d);
+            rem = cur % d;
+        }
+        trim(mag);
+        return uint32_t(rem);
+    }
+
+    // Appends mag in decimal, zero-padded on the left to width digits.
+    // powers[k] holds 10^(9 * 2^k).
+    static void appendDigits(const PyMag& mag, std::size_t width, const std::vector<PyMag>& powers,
+                             std::string& out) {
+        std::size_t k = powers.size();
+        while (k > 0 && 2 * powers[k - 1].size() > mag.size()) {
+            --k;
+        }
+        if (mag.size() < STR_SPLIT_THRESHOLD || k == 0) {
+            PyMag rest = mag;
+            std::vector<uint32_t> chunks;
+            while (!rest.empty()) {
+                chunks.push_back(divSmall(rest, 1000000000));
+            }
+            std::string digits = chunks.empty() ? "0" : std::to_string(chunks.back());
+            for (std::size_t i = chunks.size(); i-- > 1;) {
+                std::string part = std::to_string(chunks[i - 1]);
+                digits.append(9 - part.size(), '0');
+                digits += part;
+            }
+            if (digits.size() < width) {
+                out.append(width - digits.size(), '0');
+            }
+            out += digits;
+            return;
+        }
+        std::size_t low = std::size_t(9) << (k - 1);
+        PyMag q, r;
+        divMag(mag, powers[k - 1], q, r);
+        appendDigits(q, width > low ? width - low : 0, powers, out);
+        appendDigits(r, low, powers, out);
+    }
+
+    static void shiftLeft(PyMag& mag, std::size_t bits) {
+        std::size_t limbs = bits / 32;
+        unsigned shift = unsigned(bits % 32);
+        if (shift != 0) {
+            uint32_t carry = 0;
+            for (uint32_t& limb : mag) {
+                uint32_t next = limb >> (32 - shift);
+                limb = (limb << shift) | carry;
+                carry = next;
+            }
+            if (carry != 0) {
+                mag.push_back(carry);
+            }
+        }
+        mag.insert(mag.begin(), limbs, 0);
+    }
+
+    // Truncating magnitude division (Knuth, TAOCP vol. 2, algorithm D).
+    static void divMag(const PyMag& a, const PyMag& b, PyMag& q, PyMag& r) {
+        if (cmpMag(a, b) < 0) {
+            q.clear();
+            r = a;
+            return;
+        }
+        if (b.size() == 1) {
+            q = a;
+            uint32_t rem = divSmall(q, b[0]);
+            r = rem ? PyMag{rem} : PyMag();
+            return;
+        }
+        unsigned s = unsigned(__builtin_clz(b.back()));
+        PyMag v = b, u = a;
+        shiftLeft(v, s);
+        shiftLeft(u, s);
+        if (u.size() == a.size()) {
+            u.push_back(0);
+        }
+        std::size_t n = v.size(), m = u.size() - n;
+        q.assign(m, 0);
+        for (std::size_t j = m; j-- > 0;) {
+            uint64_t num = (uint64_t(u[j + n]) << 32) | u[j + n - 1];
+            uint64_t qhat = num / v[n - 1];
+            uint64_t rhat = num % v[n - 1];
+            while (qhat > 0xFFFFFFFFULL || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+                --qhat;
+                rhat += v[n - 1];
+                if (rhat > 0xFFFFFFFFULL) {
+                    break;
+                }
+            }
+            int64_t borrow = 0;
+            uint64_t carry = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                uint64_t p = qhat * v[i] + carry;
+                carry = p >> 32;
+                int64_t t = int64_t(u[i + j]) - borrow - int64_t(p & 0xFFFFFFFFULL);
+                u[i + j] = uint32_t(t);
+                borrow = t < 0 ? 1 : 0;
+            }
+            int64_t t = int64_t(u[j + n]) - borrow - int64_t(carry);
+            u[j + n] = uint32_t(t);
+            if (t < 0) {
+                // qhat was one too large; add the divisor back.
+                --qhat;
+                uint64_t c = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    c += uint64_t(u[i + j]) + v[i];
+                    u[i + j] = uint32_t(c);
+                    c >>= 32;
+                }
+                u[j + n] += uint32_t(c);
+            }
+            q[j] = uint32_t(qhat);
+        }
+        trim(q);
+        u.resize(n);
+        if (s != 0) {
+            for (std::size_t i = 0; i < n; ++i) {
+                u[i] = (u[i] >> s) | (i + 1 < n ? u[i + 1] << (32 - s) : 0);
+            }
+        }
+        trim(u);
+        r = std::move(u);
+    }
+
+    int64_t small;
+    PyBigLimbs* big;
+};
+
+template <>
+struct PyHash<PyInt> {
+    uint64_t operator()(const PyInt& v) const { return v.hash(); }
+};
+
+#endif // PYINT_H
@@ -0,0 +1,327 @@
+#ifndef PYITER_H
+#define PYITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "pyvalue.h"
+
+// enumerate, zip, map, filter and reversed as lazy views. Each adapter is a
+// template over the iterable it wraps, held by reference when it is a named
+// list and by value when it is a temporary (another adapter, sorted(...)),
+// so a chain like enumerate(zip(xs, ys)) is one nested struct of iterators
+// that the compiler inlines into a single loop. Items are built on the
+// stack as std::tuples for structured bindings; nothing is boxed and no
+// intermediate list is allocated.
+//
+// Adapter iterators carry their own end and compare against PySentinel,
+// which lets them wrap generators whose end is not an iterator.
+
+struct PySentinel {};
+
+template <class R>
+using PyIterOf = decltype(std::declval<std::remove_reference_t<R>&>().begin());
+
+template <class R>
+using PyEndOf = decltype(std::declval<std::remove_reference_t<R>&>().end());
+
+template <class R>
+using PyItemOf = decltype(*std::declval<const PyIterOf<R>&>());
+
+// Iterables that know their length up front. zip over those counts down
+// the shortest length instead of testing every iterator, which is the
+// loop a hand-written indexed version would have.
+template <class R, class = void>
+struct PyIsSized : std::false_type {};
+
+template <class R>
+struct PyIsSized<R, std::void_t<decltype(std::declval<const std::remove_reference_t<R>&>().size())>> : std::true_type {};
+
+// The length to reserve for a comprehension over range: its size, or 0
+// when the iterable cannot tell without being consumed.
+template <class R>
+std::size_t pyLengthHint(const R& range) {
+    if constexpr (PyIsSized<R>::value) {
+        return range.size();
+    } else {
+        return 0;
+    }
+}
+
+inline bool pyIsTrue(const PyValue& v) {
+    return v.truthy();
+}
+
+template <class T>
+bool pyIsTrue(const T& v) {
+    return bool(v);
+}
+
+template <class... Ts>
+bool pyIsTrue(const std::tuple<Ts...>&) {
+    return sizeof...(Ts) > 0;
+}
+
+template <class R>
+class PyEnumerate {
+public:
+    class iterator {
+    public:
+        iterator(PyIterOf<R> at, PyEndOf<R> stop, int64_t count) : at(at), stop(stop), count(count) {}
+        std::tuple<int64_t, PyItemOf<R>> operator*() const { return {count, *at}; }
+        iterator& operator++() {
+            ++at;
+            ++count;
+            return *this;
+        }
+        bool operator!=(PySentinel) const { return at != stop; }
+
+    private:
+        PyIterOf<R> at;
+        PyEndOf<R> stop;
+        int64_t count;
+    };
+
+    PyEnumerate(R&& range, int64_t start) : range(std::forward<R>(range)), start(start) {}
+
+    iterator begin() { return iterator(range.begin(), range.end(), start); }
+    PySentinel end() { return {}; }
+
+    template <class Q = R, class = std::enable_if_t<PyIsSized<Q>::value>>
+    std::size_t size() const { return range.size(); }
+
+private:
+    R range;
+    int64_t start;
+};
+
+template <class... Rs>
+class PyZip {
+    static constexpr bool SIZED = (PyIsSized<Rs>::value && ...);
+
+public:
+    class iterator {
+    public:
+        iterator(std::tuple<PyIterOf<Rs>...> at, std::tuple<PyEndOf<Rs>...> stop, std::size_t left)
+            : at(at), stop(stop), left(left) {}
+        std::tuple<PyItemOf<Rs>...> operator*() const {
+            return std::apply([](const auto&... it) { return std::tuple<PyItemOf<Rs>...>(*it...); }, at);
+        }
+        iterator& operator++() {
+            std::apply([](auto&... it) { (++it, ...); }, at);
+            if constexpr (SIZED) {
+                --left;
+            }
+            return *this;
+        }
+        bool operator!=(PySentinel) const {
+            if constexpr (SIZED) {
+                return left != 0;
+            } else {
+                return running(std::index_sequence_for<Rs...>());
+            }
+        }
+
+    private:
+        // Stops at the shortest iterable, as Python's zip does.
+        template <std::size_t... I>
+        bool running(std::index_sequence<I...>) const {
+            return ((std::get<I>(at) != std::get<I>(stop)) && ...);
+        }
+
+        std::tuple<PyIterOf<Rs>...> at;
+        std::tuple<PyEndOf<Rs>...> stop;
+        std::size_t left;
+    };
+
+    explicit PyZip(Rs&&... ranges) : ranges(std::forward<Rs>(ranges)...) {}
+
+    iterator begin() {
+        std::size_t left = 0;
+        if constexpr (SIZED) {
+            left = size();
+        }
+        return iterator(std::apply([](auto&... r) { return std::tuple<PyIterOf<Rs>...>(r.begin()...); }, ranges),
+                        std::apply([](auto&... r) { return std::tuple<PyEndOf<Rs>...>(r.end()...); }, ranges), left);
+    }
+    PySentinel end() { return {}; }
+
+    template <bool Q = SIZED, class = std::enable_if_t<Q>>
+    std::size_t size() const {
+        return std::apply([](const auto&... r) {
+            std::size_t n = SIZE_MAX;
+            ((n = r.size() < n ? r.size() : n), ...);
+            return n;
+        }, ranges);
+    }
+
+private:
+    std::tuple<Rs...> ranges;
+};
+
+template <class F, class R>
+class PyMap {
+public:
+    class iterator {
+    public:
+        iterator(F* f, PyIterOf<R> at, PyEndOf<R> stop) : f(f), at(at), stop(stop) {}
+        decltype(auto) operator*() const { return (*f)(*at); }
+        iterator& operator++() {
+            ++at;
+            return *this;
+        }
+        bool operator!=(PySentinel) const { return at != stop; }
+
+    private:
+        F* f;
+        PyIterOf<R> at;
+        PyEndOf<R> stop;
+    };
+
+    PyMap(F f, R&& range) : f(std::move(f)), range(std::forward<R>(range)) {}
+
+    iterator begin() { return iterator(&f, range.begin(), range.end()); }
+    PySentinel end() { return {}; }
+
+    template <class Q = R, class = std::enable_if_t<PyIsSized<Q>::value>>
+    std::size_t size() const { return range.size(); }
+
+private:
+    F f;
+    R range;
+};
+
+// map(f, xs, ys) calls f(x, y): the items of a zip are spread over the
+// arguments.
+template <class F>
+struct PySpread {
+    F f;
+    template <class T>
+    decltype(auto) operator()(T&& items) { return std::apply(f, std::forward<T>(items)); }
+};
+
+// The current item is kept in the iterator so a predicate over a map sees
+// each mapped value once and the loop body does not recompute it.
+template <class F, class R>
+class PyFilter {
+public:
+    class iterator {
+    public:
+        iterator(F* f, PyIterOf<R> at, PyEndOf<R> stop) : f(f), at(at), stop(stop) { skip(); }
+        const std::decay_t<PyItemOf<R>>& operator*() const { return *item; }
+        iterator& operator++() {
+            ++at;
+            skip();
+            return *this;
+        }
+        bool operator!=(PySentinel) const { return at != stop; }
+
+    private:
+        void skip() {
+            for (; at != stop; ++at) {
+                item.emplace(*at);
+                if (pyIsTrue((*f)(*item))) {
+                    return;
+                }
+            }
+        }
+
+        F* f;
+        PyIterOf<R> at;
+        PyEndOf<R> stop;
+        std::optional<std::decay_t<PyItemOf<R>>> item;
+    };
+
+    PyFilter(F f, R&& range) : f(std::move(f)), range(std::forward<R>(range)) {}
+
+    iterator begin() { return iterator(&f, range.begin(), range.end()); }
+    PySentinel end() { return {}; }
+
+private:
+    F f;
+    R range;
+};
+
+// filter(None, xs) keeps the truthy items.
+struct PyIdentity {
+    template <class T>
+    const T& operator()(const T& item) const { return item; }
+};
+
+// Walks a list (or anything whose iterator steps backwards) from the end
+// without copying it.
+template <class R>
+class PyReversed {
+public:
+    class iterator {
+    public:
+        iterator(PyIterOf<R> at, PyIterOf<R> first) : at(at), first(first) {}
+        PyItemOf<R> operator*() const {
+            PyIterOf<R> item = at;
+            --item;
+            return *item;
+        }
+        iterator& operator++() {
+            --at;
+            return *this;
+        }
+        bool operator!=(PySentinel) const { return at != first; }
+
+    private:
+        PyIterOf<R> at;
+        PyIterOf<R> first;
+    };
+
+    explicit PyReversed(R&& range) : range(std::forward<R>(range)) {}
+
+    iterator begin() { return iterator(range.end(), range.begin()); }
+    PySentinel end() { return {}; }
+
+    template <class Q = R, class = std::enable_if_t<PyIsSized<Q>::value>>
+    std::size_t size() const { return range.size(); }
+
+private:
+    R range;
+};
+
+template <class R>
+PyEnumerate<R> pyEnumerate(R&& range, int64_t start = 0) {
+    return PyEnumerate<R>(std::forward<R>(range), start);
+}
+
+template <class... Rs>
+PyZip<Rs...> pyZip(Rs&&... ranges) {
+    return PyZip<Rs...>(std::forward<Rs>(ranges)...);
+}
+
+template <class F, class R>
+PyMap<F, R> pyMap(F f, R&& range) {
+    return PyMap<F, R>(std::move(f), std::forward<R>(range));
+}
+
+template <class F, class R, class... Rs>
+PyMap<PySpread<F>, PyZip<R, Rs...>> pyMap(F f, R&& range, Rs&&... ranges) {
+    return PyMap<PySpread<F>, PyZip<R, Rs...>>(PySpread<F>{std::move(f)},
+                                               pyZip(std::forward<R>(range), std::forward<Rs>(ranges)...));
+}
+
+template <class F, class R>
+PyFilter<F, R> pyFilter(F f, R&& range) {
+    return PyFilter<F, R>(std::move(f), std::forward<R>(range));
+}
+
+template <class R>
+PyFilter<PyIdentity, R> pyFilter(R&& range) {
+    return PyFilter<PyIdentity, R>(PyIdentity(), std::forward<R>(range));
+}
+
+template <class R>
+PyReversed<R> pyReversed(R&& range) {
+    return PyReversed<R>(std::forward<R>(range));
+}
+
+#endif // PYITER_H
@@ -0,0 +1,270 @@
+#ifndef PYLIST_H
+#define PYLIST_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pyvalue.h"
+
+// Python list that keeps unboxed storage while every element is an int
+// (fitting int64) or every element is a float. Storing anything else converts
+// the list once to a vector of PyValue, after which it stays generic.
+// Numeric loops can take ints() or floats() and run over contiguous memory.
+class PyList {
+public:
+    enum Kind { EMPTY, INTS, FLOATS, GENERIC };
+
+    class iterator {
+    public:
+        iterator(const PyList* list, std::size_t i) : list(list), i(i) {}
+        PyValue operator*() const { return list->at(i); }
+        iterator& operator++() {
+            ++i;
+            return *this;
+        }
+        iterator& operator--() {
+            --i;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return i == other.i; }
+        bool operator!=(const iterator& other) const { return i != other.i; }
+
+    private:
+        const PyList* list;
+        std::size_t i;
+    };
+
+    PyList() : kind(EMPTY) {}
+    PyList(std::initializer_list<PyValue> values) : kind(EMPTY) {
+        reserve(values.size());
+        for (const PyValue& v : values) {
+            append(v);
+        }
+    }
+
+    static PyList ofInts(std::vector<int64_t> values) {
+        PyList list;
+        list.kind = INTS;
+        list.intItems = std::move(values);
+        return list;
+    }
+    static PyList ofFloats(std::vector<double> values) {
+        PyList list;
+        list.kind = FLOATS;
+        list.floatItems = std::move(values);
+        return list;
+    }
+
+    Kind storage() const { return kind; }
+
+    std::size_t size() const {
+        switch (kind) {
+            case INTS: return intItems.size();
+            case FLOATS: return floatItems.size();
+            case GENERIC: return items.size();
+            default: return 0;
+        }
+    }
+    bool empty() const { return size() == 0; }
+
+    void reserve(std::size_t n) {
+        switch (kind) {
+            case INTS: intItems.reserve(n); break;
+            case FLOATS: floatItems.reserve(n); break;
+            case GENERIC: items.reserve(n); break;
+            default: pendingReserve = n; break;
+        }
+    }
+
+    void append(int v) { append(int64_t(v)); }
+    void append(int64_t v) {
+        if (kind == EMPTY) {
+            become(INTS);
+        }
+        if (kind == INTS) {
+            intItems.push_back(v);
+        } else {
+            append(PyValue(v));
+        }
+    }
+    void append(double v) {
+        if (kind == EMPTY) {
+            become(FLOATS);
+        }
+        if (kind == FLOATS) {
+            floatItems.push_back(v);
+        } else {
+            append(PyValue(v));
+        }
+    }
+    void append(const PyValue& v) {
+        if (kind == EMPTY) {
+            become(v.isFloat() ? FLOATS : fitsInts(v) ? INTS : GENERIC);
+        }
+        if (kind == INTS && fitsInts(v)) {
+            intItems.push_back(v.asInt());
+        } else if (kind == FLOATS && v.isFloat()) {
+            floatItems.push_back(v.asFloat());
+        } else {
+            generalize();
+            items.push_back(v);
+        }
+    }
+
+    PyValue operator[](int64_t i) const { return at(checkIndex(i)); }
+    PyValue operator[](const PyValue& i) const { return (*this)[i.asInt()]; }
+    void set(int64_t i, const PyValue& v) {
+        std::size_t at = checkIndex(i);
+        if (kind == INTS && fitsInts(v)) {
+            intItems[at] = v.asInt();
+        } else if (kind == FLOATS && v.isFloat()) {
+            floatItems[at] = v.asFloat();
+        } else {
+            generalize();
+            items[at] = v;
+        }
+    }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+    PyValue pop() {
+        if (empty()) {
+            throw std::out_of_range("IndexError: pop from empty list");
+        }
+        PyValue last = (*this)[-1];
+        switch (kind) {
+            case INTS: intItems.pop_back(); break;
+            case FLOATS: floatItems.pop_back(); break;
+            default: items.pop_back(); break;
+        }
+        return last;
+    }
+
+    // Unboxed storage; only valid while storage() reports the matching kind.
+    std::vector<int64_t>& ints() { return intItems; }
+    const std::vector<int64_t>& ints() const { return intItems; }
+    std::vector<double>& floats() { return floatItems; }
+    const std::vector<double>& floats() const { return floatItems; }
+
+    // The one-time conversion to boxed storage.
+    void generalize() {
+        if (kind == GENERIC) {
+            return;
+        }
+        items.reserve(size() + 1);
+        for (int64_t v : intItems) {
+            items.push_back(PyValue(v));
+        }
+        for (double v : floatItems) {
+            items.push_back(PyValue(v));
+        }
+        intItems = std::vector<int64_t>();
+        floatItems = std::vector<double>();
+        kind = GENERIC;
+    }
+    std::vector<PyValue>& values() {
+        generalize();
+        return items;
+    }
+
+    // Unboxed storage holds no objects; boxed items are marked one by one.
+    void share() const {
+        for (const PyValue& v : items) {
+            v.share();
+        }
+    }
+
+    std::string str() const {
+        std::string s = "[";
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (i > 0) {
+                s += ", ";
+            }
+            PyValue v = (*this)[int64_t(i)];
+            s += v.isStr() ? "'" + v.str() + "'" : v.str();
+        }
+        return s + "]";
+    }
+    friend bool operator==(const PyList& a, const PyList& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        if (a.kind == INTS && b.kind == INTS) {
+            return a.intItems == b.intItems;
+        }
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (a[int64_t(i)] != b[int64_t(i)]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    friend bool operator!=(const PyList& a, const PyList& b) { return !(a == b); }
+
+    friend std::ostream& operator<<(std::ostream& os, const PyList& list) {
+        return os << list.str();
+    }
+
+private:
+    static bool fitsInts(const PyValue& v) {
+        return v.isInt() && v.asPyInt().isSmall();
+    }
+
+    PyValue at(std::size_t i) const {
+        switch (kind) {
+            case INTS: return PyValue(intItems[i]);
+            case FLOATS: return PyValue(floatItems[i]);
+            default: return items[i];
+        }
+    }
+
+    void become(Kind k) {
+        kind = k;
+        reserve(pendingReserve);
+    }
+
+    std::size_t checkIndex(int64_t i) const {
+        int64_t n = int64_t(size());
+        if (i < 0) {
+            i += n;
+        }
+        if (i < 0 || i >= n) {
+            throw std::out_of_range("IndexError: list index out of range");
+        }
+        return std::size_t(i);
+    }
+
+    Kind kind;
+    std::size_t pendingReserve = 0;
+    std::vector<int64_t> intItems;
+    std::vector<double> floatItems;
+    std::vector<PyValue> items;
+};
+
+// A list inside a PyValue: an element of a nested list, or an argument to
+// an untyped parameter.
+struct PyBoxedList : PyBoxedContainer {
+    explicit PyBoxedList(PyList v) : value(std::move(v)) {}
+    void shareChildren() override { value.share(); }
+    std::size_t length() const override { return value.size(); }
+    PyValue item(std::size_t i) const override { return value[int64_t(i)]; }
+    std::string repr() const override { return value.str(); }
+    PyList value;
+};
+
+inline PyValue::PyValue(const PyList& list) : bits(boxObject(new PyBoxedList(list))) {}
+
+// Generic reducers and sorted() take their iterable by forwarding
+// reference, because a lazy view's begin() is not const. This keeps those
+// templates from outbidding the PyList overloads that know the storage.
+template <class T>
+using PyIfNotList = std::enable_if_t<!std::is_same_v<std::decay_t<T>, PyList>, int>;
+
+#endif // PYLIST_H
@@ -0,0 +1,138 @@
+#ifndef PYMEMO_H
+#define PYMEMO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "pydict.h"
+#include "pytuple.h"
+#include "pyvalue.h"
+
+// Memo table behind functools.lru_cache and functools.cache. Calls are
+// keyed on a tuple of the function's declared parameter types, hashed and
+// compared field by field, so inline ints and strs are looked up without
+// boxing. With a maxsize the entries are threaded on an intrusive list by
+// index, most recently used first, and a miss on a full cache reuses the
+// tail entry. As in Python, a failing call caches nothing and a result
+// cached during the call (by recursion) is kept.
+
+struct PyCacheInfo {
+    int64_t hits;
+    int64_t misses;
+    int64_t maxsize; // -1 for None
+    int64_t currsize;
+
+    friend std::ostream& operator<<(std::ostream& os, const PyCacheInfo& info) {
+        os << "CacheInfo(hits=" << info.hits << ", misses=" << info.misses << ", maxsize=";
+        if (info.maxsize < 0) {
+            os << "None";
+        } else {
+            os << info.maxsize;
+        }
+        return os << ", currsize=" << info.currsize << ")";
+    }
+};
+
+template <class R, class... Args>
+class PyLruCache {
+public:
+    typedef std::tuple<Args...> Key;
+
+    // Negative means unbounded, like maxsize=None.
+    explicit PyLruCache(int64_t maxsize) : maxsize(maxsize) {}
+
+    template <class F>
+    R call(F compute, const Args&... args) {
+        if (maxsize == 0) {
+            ++misses;
+            return compute();
+        }
+        Key key(args...);
+        if (const uint32_t* node = index.find(key)) {
+            ++hits;
+            touch(*node);
+            return nodes[*node].value;
+        }
+        ++misses;
+        R result = compute();
+        if (!index.contains(key)) {
+            store(std::move(key), result);
+        }
+        return result;
+    }
+
+    void cacheClear() {
+        index.clear();
+        nodes.clear();
+        head = tail = NIL;
+        hits = misses = 0;
+    }
+
+    PyCacheInfo cacheInfo() const {
+        return {hits, misses, maxsize < 0 ? -1 : maxsize, int64_t(index.size())};
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        Key key;
+        R value;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    bool bounded() const { return maxsize > 0; }
+
+    void unlink(uint32_t n) {
+        Node& node = nodes[n];
+        (node.prev != NIL ? nodes[node.prev].next : head) = node.next;
+        (node.next != NIL ? nodes[node.next].prev : tail) = node.prev;
+    }
+
+    void pushFront(uint32_t n) {
+        nodes[n].prev = NIL;
+        nodes[n].next = head;
+        (head != NIL ? nodes[head].prev : tail) = n;
+        head = n;
+    }
+
+    void touch(uint32_t n) {
+        if (bounded() && head != n) {
+            unlink(n);
+            pushFront(n);
+        }
+    }
+
+    void store(Key key, const R& value) {
+        uint32_t n;
+        if (bounded() && int64_t(nodes.size()) >= maxsize) {
+            n = tail;
+            unlink(n);
+            index.erase(nodes[n].key);
+            nodes[n].key = std::move(key);
+            nodes[n].value = value;
+        } else {
+            n = uint32_t(nodes.size());
+            nodes.push_back({std::move(key), value, NIL, NIL});
+        }
+        index[nodes[n].key] = n;
+        if (bounded()) {
+            pushFront(n);
+        }
+    }
+
+    int64_t maxsize;
+    PyDict<Key, uint32_t> index;
+    std::vector<Node> nodes;
+    uint32_t head = NIL;
+    uint32_t tail = NIL;
+    int64_t hits = 0;
+    int64_t misses = 0;
+};
+
+#endif // PYMEMO_H
@@ -0,0 +1,140 @@
+#ifndef PYOBJECT_H
+#define PYOBJECT_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Memory management for heap objects in generated programs.
+//
+// REFCOUNT is the default: plain increments, no atomics, except on objects
+// marked shared. The threading runtime marks everything it hands to another
+// thread (arguments, results), so single-threaded objects never pay for
+// atomics. ATOMIC_REFCOUNT makes every count atomic, for programs that pass
+// objects between threads in ways the runtime cannot see. ARENA is an
+// opt-in mode for short-lived scripts: objects are bump-allocated, reference
+// counts are ignored and nothing is freed before exit.
+enum PyMemoryMode {
+    REFCOUNT, ATOMIC_REFCOUNT, ARENA
+};
+
+inline PyMemoryMode pyMemoryMode = REFCOUNT;
+
+// Objects that already exist keep their counts, so the switch is safe at
+// any point before a second thread starts.
+inline void pyEnableThreads() {
+    if (pyMemoryMode == REFCOUNT) {
+        pyMemoryMode = ATOMIC_REFCOUNT;
+    }
+}
+
+// Objects created before this call are simply never freed afterwards.
+inline void pyUseArena() {
+    pyMemoryMode = ARENA;
+}
+
+class PyArena {
+public:
+    static constexpr std::size_t kChunkSize = 64 * 1024;
+
+    void* allocate(std::size_t size) {
+        size = (size + 15) & ~std::size_t(15);
+        if (size > std::size_t(end - cursor)) {
+            if (size > kChunkSize / 4) {
+                return allocateChunk(size);
+            }
+            cursor = static_cast<char*>(allocateChunk(kChunkSize));
+            end = cursor + kChunkSize;
+        }
+        void* p = cursor;
+        cursor += size;
+        return p;
+    }
+
+    static PyArena& local() {
+        thread_local PyArena arena;
+        return arena;
+    }
+
+private:
+    // Chunks are deliberately leaked: arena objects may be reachable until exit.
+    static void* allocateChunk(std::size_t size) {
+        void* p = std::malloc(size);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    char* cursor = nullptr;
+    char* end = nullptr;
+};
+
+struct PyObject {
+    virtual ~PyObject() = default;
+
+    static void* operator new(std::size_t size) {
+        if (pyMemoryMode == ARENA) {
+            return PyArena::local().allocate(size);
+        }
+        return ::operator new(size);
+    }
+    static void operator delete(void* p) {
+        if (pyMemoryMode != ARENA) {
+            ::operator delete(p);
+        }
+    }
+
+    // Marks the objects this one owns as shared too.
+    virtual void shareChildren() {}
+
+    long refcount = 1;
+    bool shared = false;
+};
+
+// Must happen before obj is published to another thread; the publication
+// (thread start, queue handoff) orders the flag before any remote access.
+inline void pyShare(PyObject* obj) {
+    if (obj && !obj->shared) {
+        obj->shared = true;
+        obj->shareChildren();
+    }
+}
+
+inline void pyIncRef(PyObject* obj) {
+    switch (pyMemoryMode) {
+        case REFCOUNT:
+            if (!obj->shared) {
+                ++obj->refcount;
+                break;
+            }
+            [[fallthrough]];
+        case ATOMIC_REFCOUNT:
+            __atomic_add_fetch(&obj->refcount, 1, __ATOMIC_RELAXED);
+            break;
+        case ARENA:
+            break;
+    }
+}
+
+inline void pyDecRef(PyObject* obj) {
+    switch (pyMemoryMode) {
+        case REFCOUNT:
+            if (!obj->shared) {
+                if (--obj->refcount == 0) {
+                    delete obj;
+                }
+                break;
+            }
+            [[fallthrough]];
+        case ATOMIC_REFCOUNT:
+            if (__atomic_sub_fetch(&obj->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+                delete obj;
+            }
+            break;
+        case ARENA:
+            break;
+    }
+}
+
+#endif // PYOBJECT_H
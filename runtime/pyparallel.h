@@ -0,0 +1,58 @@
+#ifndef PYPARALLEL_H
+#define PYPARALLEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "pythread.h"
+
+// Runtime side of loop auto-parallelization. The translator only emits
+// these calls for `for i in range(...)` loops whose body is nothing but
+// reductions of pure expressions, so iterations can run in any order.
+
+// Loops shorter than this run serially; spreading them over threads costs
+// more than it saves.
+const int64_t PY_PARALLEL_MIN_TRIPS = 10000;
+
+inline PyThreadPoolExecutor& pyParallelPool() {
+    static PyThreadPoolExecutor* pool = new PyThreadPoolExecutor(std::max(1u, std::thread::hardware_concurrency()));
+    return *pool;
+}
+
+// Folds combine(acc, value(i)) over [start, stop). Each chunk folds its own
+// range starting from its first value, then the partial results are folded
+// into init in chunk order, so for an associative combine the result equals
+// the serial left fold (float sums may differ in the last bits).
+template <class T, class Value, class Combine>
+T pyParallelReduce(int64_t start, int64_t stop, T init, Value value, Combine combine,
+                   int64_t minTrips = PY_PARALLEL_MIN_TRIPS, PyThreadPoolExecutor& pool = pyParallelPool()) {
+    int64_t trips = stop - start;
+    if (trips < minTrips || trips < 2 || pool.size() < 2) {
+        for (int64_t i = start; i < stop; ++i) {
+            init = combine(init, value(i));
+        }
+        return init;
+    }
+    int64_t chunks = std::min<int64_t>(trips, int64_t(pool.size()) * 4);
+    std::vector<PyFuture<T>> partials;
+    partials.reserve(std::size_t(chunks));
+    for (int64_t c = 0; c < chunks; ++c) {
+        int64_t lo = start + trips * c / chunks;
+        int64_t hi = start + trips * (c + 1) / chunks;
+        partials.push_back(pool.submit([&value, &combine, lo, hi]() -> T {
+            T acc = value(lo);
+            for (int64_t i = lo + 1; i < hi; ++i) {
+                acc = combine(acc, value(i));
+            }
+            return acc;
+        }));
+    }
+    for (const PyFuture<T>& partial : partials) {
+        init = combine(init, partial.result());
+    }
+    return init;
+}
+
+#endif // PYPARALLEL_H
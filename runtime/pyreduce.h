@@ -0,0 +1,360 @@
+#ifndef PYREDUCE_H
+#define PYREDUCE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "pyint.h"
+#include "pylist.h"
+#include "pyvalue.h"
+
+// sum(), min(), max(), any() and all(). Unboxed int and float lists run as
+// SIMD kernels: AVX2 when compiled for it, otherwise scalar loops over
+// independent lanes that the compiler can vectorize. Any other iterable is
+// folded item by item. Python semantics are kept: int sums promote to PyInt
+// instead of wrapping, min/max ignore a NaN unless it comes first, and of
+// equal values the first one wins.
+//
+// Float sums add eight interleaved partial sums (the same ones with or
+// without AVX2), which rounds differently from a left-to-right sum. Define
+// PY_STRICT_FLOAT_ORDER to get left folds, as a loop of additions computes.
+
+// The exact sum, switching to PyInt whenever int64 would overflow.
+inline PyInt pySumIntsExact(const int64_t* data, std::size_t n) {
+    PyInt big(0);
+    int64_t part = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        int64_t next;
+        if (__builtin_add_overflow(part, data[i], &next)) {
+            big = big + PyInt(part);
+            part = data[i];
+        } else {
+            part = next;
+        }
+    }
+    return big + PyInt(part);
+}
+
+// Adds four wrapping lanes and records whether any lane overflowed; only
+// then is the sum redone exactly.
+inline PyValue pySumInts(const int64_t* data, std::size_t n) {
+    uint64_t lanes[4] = {0, 0, 0, 0};
+    uint64_t overflow = 0;
+    std::size_t i = 0;
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    __m256i over = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i sum = _mm256_add_epi64(acc, x);
+        // Overflow: both operands have one sign and the sum the other.
+        over = _mm256_or_si256(over, _mm256_andnot_si256(_mm256_xor_si256(acc, x), _mm256_xor_si256(acc, sum)));
+        acc = sum;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    overflow = uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(over)));
+#endif
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            uint64_t x = uint64_t(data[i + k]);
+            uint64_t sum = lanes[k] + x;
+            overflow |= (~(lanes[k] ^ x) & (lanes[k] ^ sum)) >> 63;
+            lanes[k] = sum;
+        }
+    }
+    int64_t total = 0;
+    bool wrapped = overflow != 0;
+    for (std::size_t k = 0; k < 4; ++k) {
+        wrapped |= __builtin_add_overflow(total, int64_t(lanes[k]), &total);
+    }
+    for (; i < n; ++i) {
+        wrapped |= __builtin_add_overflow(total, data[i], &total);
+    }
+    return wrapped ? PyValue(pySumIntsExact(data, n)) : PyValue(total);
+}
+
+// Element i goes to lane i % 8; the lanes are combined pairwise.
+inline double pySumFloats(const double* data, std::size_t n) {
+    double lanes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    std::size_t i = 0;
+#ifdef __AVX2__
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+        low = _mm256_add_pd(low, _mm256_loadu_pd(data + i));
+        high = _mm256_add_pd(high, _mm256_loadu_pd(data + i + 4));
+    }
+    _mm256_storeu_pd(lanes, low);
+    _mm256_storeu_pd(lanes + 4, high);
+#endif
+    for (; i + 8 <= n; i += 8) {
+        for (std::size_t k = 0; k < 8; ++k) {
+            lanes[k] += data[i + k];
+        }
+    }
+    for (std::size_t k = 0; i < n; ++i, ++k) {
+        lanes[k] += data[i];
+    }
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+// min (Max false) or max of n >= 1 ints.
+template <bool Max>
+int64_t pyExtremeInts(const int64_t* data, std::size_t n) {
+    int64_t lanes[4] = {data[0], data[0], data[0], data[0]};
+    std::size_t i = 1;
+#ifdef __AVX2__
+    __m256i wide = _mm256_set1_epi64x(data[0]);
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i better = Max ? _mm256_cmpgt_epi64(x, wide) : _mm256_cmpgt_epi64(wide, x);
+        wide = _mm256_blendv_epi8(wide, x, better);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), wide);
+#endif
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            int64_t x = data[i + k];
+            lanes[k] = (Max ? x > lanes[k] : x < lanes[k]) ? x : lanes[k];
+        }
+    }
+    int64_t best = lanes[0];
+    for (std::size_t k = 1; k < 4; ++k) {
+        best = (Max ? lanes[k] > best : lanes[k] < best) ? lanes[k] : best;
+    }
+    for (; i < n; ++i) {
+        best = (Max ? data[i] > best : data[i] < best) ? data[i] : best;
+    }
+    return best;
+}
+
+// min or max of n >= 1 floats. Like Python's pairwise comparisons, a
+// leading NaN wins and any later NaN never compares better.
+template <bool Max>
+double pyExtremeFloats(const double* data, std::size_t n) {
+    if (std::isnan(data[0])) {
+        return data[0];
+    }
+    double lanes[4] = {data[0], data[0], data[0], data[0]};
+    std::size_t i = 1;
+#ifdef __AVX2__
+    // maxpd/minpd return the second operand when either is NaN.
+    __m256d wide = _mm256_set1_pd(data[0]);
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(data + i);
+        wide = Max ? _mm256_max_pd(x, wide) : _mm256_min_pd(x, wide);
+    }
+    _mm256_storeu_pd(lanes, wide);
+#endif
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            double x = data[i + k];
+            lanes[k] = (Max ? x > lanes[k] : x < lanes[k]) ? x : lanes[k];
+        }
+    }
+    double best = lanes[0];
+    for (std::size_t k = 1; k < 4; ++k) {
+        best = (Max ? lanes[k] > best : lanes[k] < best) ? lanes[k] : best;
+    }
+    for (; i < n; ++i) {
+        best = (Max ? data[i] > best : data[i] < best) ? data[i] : best;
+    }
+    // 0.0 and -0.0 compare equal, so the first zero is the one returned.
+    if (best == 0.0) {
+        for (i = 0; data[i] != 0.0; ++i) {
+        }
+        return data[i];
+    }
+    return best;
+}
+
+// any() (All false) or all() over ints, in blocks so each block vectorizes
+// and the scan still stops early.
+template <bool All>
+bool pyTruthInts(const int64_t* data, std::size_t n) {
+    std::size_t i = 0;
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 16 <= n; i += 16) {
+        __m256i hits = zero;
+        for (std::size_t k = 0; k < 16; k += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + k));
+            hits = _mm256_or_si256(hits, All ? _mm256_cmpeq_epi64(x, zero) : x);
+        }
+        if (!_mm256_testz_si256(hits, hits)) {
+            return !All;
+        }
+    }
+#endif
+    for (; i + 64 <= n; i += 64) {
+        bool hit = false;
+        for (std::size_t k = 0; k < 64; ++k) {
+            hit |= All ? data[i + k] == 0 : data[i + k] != 0;
+        }
+        if (hit) {
+            return !All;
+        }
+    }
+    for (; i < n; ++i) {
+        if (All ? data[i] == 0 : data[i] != 0) {
+            return !All;
+        }
+    }
+    return All;
+}
+
+// The same over floats; NaN is truthy.
+template <bool All>
+bool pyTruthFloats(const double* data, std::size_t n) {
+    std::size_t i = 0;
+#ifdef __AVX2__
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 16 <= n; i += 16) {
+        __m256d hits = zero;
+        for (std::size_t k = 0; k < 16; k += 4) {
+            __m256d x = _mm256_loadu_pd(data + i + k);
+            hits = _mm256_or_pd(hits, All ? _mm256_cmp_pd(x, zero, _CMP_EQ_OQ) : _mm256_cmp_pd(x, zero, _CMP_NEQ_UQ));
+        }
+        if (_mm256_movemask_pd(hits) != 0) {
+            return !All;
+        }
+    }
+#endif
+    for (; i + 64 <= n; i += 64) {
+        bool hit = false;
+        for (std::size_t k = 0; k < 64; ++k) {
+            hit |= All ? data[i + k] == 0.0 : !(data[i + k] == 0.0);
+        }
+        if (hit) {
+            return !All;
+        }
+    }
+    for (; i < n; ++i) {
+        if (All ? data[i] == 0.0 : !(data[i] == 0.0)) {
+            return !All;
+        }
+    }
+    return All;
+}
+
+template <class Iterable, PyIfNotList<Iterable> = 0>
+PyValue pySum(Iterable&& items, PyValue start = PyValue(0)) {
+    for (const auto& item : items) {
+        start = start + PyValue(item);
+    }
+    return start;
+}
+
+inline PyValue pySum(const PyList& list, PyValue start = PyValue(0)) {
+    if (list.empty()) {
+        return start;
+    }
+    switch (list.storage()) {
+        case PyList::INTS:
+            return start + pySumInts(list.ints().data(), list.size());
+        case PyList::FLOATS: {
+#ifdef PY_STRICT_FLOAT_ORDER
+            const std::vector<double>& items = list.floats();
+            double total = (start + PyValue(items[0])).asFloat();
+            for (std::size_t i = 1; i < items.size(); ++i) {
+                total += items[i];
+            }
+            return PyValue(total);
+#else
+            return start + PyValue(pySumFloats(list.floats().data(), list.size()));
+#endif
+        }
+        default:
+            for (PyValue item : list) {
+                start = start + item;
+            }
+            return start;
+    }
+}
+
+template <bool Max, class Iterable>
+PyValue pyExtremeValues(Iterable&& items) {
+    bool empty = true;
+    PyValue best;
+    for (const auto& item : items) {
+        PyValue v(item);
+        if (empty || (Max ? best < v : v < best)) {
+            best = v;
+        }
+        empty = false;
+    }
+    if (empty) {
+        throw std::invalid_argument(Max ? "ValueError: max() arg is an empty sequence" : "ValueError: min() arg is an empty sequence");
+    }
+    return best;
+}
+
+template <bool Max, class Iterable, PyIfNotList<Iterable> = 0>
+PyValue pyExtreme(Iterable&& items) {
+    return pyExtremeValues<Max>(std::forward<Iterable>(items));
+}
+
+template <bool Max>
+PyValue pyExtreme(const PyList& list) {
+    if (list.empty() || list.storage() == PyList::GENERIC) {
+        return pyExtremeValues<Max>(list);
+    }
+    if (list.storage() == PyList::INTS) {
+        return PyValue(pyExtremeInts<Max>(list.ints().data(), list.size()));
+    }
+    return PyValue(pyExtremeFloats<Max>(list.floats().data(), list.size()));
+}
+
+template <class Iterable>
+PyValue pyMin(Iterable&& items) {
+    return pyExtreme<false>(std::forward<Iterable>(items));
+}
+
+template <class Iterable>
+PyValue pyMax(Iterable&& items) {
+    return pyExtreme<true>(std::forward<Iterable>(items));
+}
+
+template <bool All, class Iterable>
+bool pyTruthValues(Iterable&& items) {
+    for (const auto& item : items) {
+        if (PyValue(item).truthy() != All) {
+            return !All;
+        }
+    }
+    return All;
+}
+
+template <bool All, class Iterable, PyIfNotList<Iterable> = 0>
+bool pyTruth(Iterable&& items) {
+    return pyTruthValues<All>(std::forward<Iterable>(items));
+}
+
+template <bool All>
+bool pyTruth(const PyList& list) {
+    switch (list.storage()) {
+        case PyList::INTS: return pyTruthInts<All>(list.ints().data(), list.size());
+        case PyList::FLOATS: return pyTruthFloats<All>(list.floats().data(), list.size());
+        case PyList::GENERIC: return pyTruthValues<All>(list);
+        default: return All;
+    }
+}
+
+template <class Iterable>
+PyValue pyAny(Iterable&& items) {
+    return PyValue(pyTruth<false>(std::forward<Iterable>(items)));
+}
+
+template <class Iterable>
+PyValue pyAll(Iterable&& items) {
+    return PyValue(pyTruth<true>(std::forward<Iterable>(items)));
+}
+
+#endif // PYREDUCE_H
@@ -0,0 +1,88 @@
+#ifndef PYSEARCH_H
+#define PYSEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Byte-level search used by the str builtins. With AVX2 the substring
+// search compares the needle's first and last bytes against 32 haystack
+// positions at once and only verifies positions where both match; without
+// it, memchr finds candidates for the first byte.
+
+const std::size_t PY_NPOS = std::size_t(-1);
+
+inline std::size_t pyFindByte(const char* hay, std::size_t n, char c) {
+    const void* p = std::memchr(hay, c, n);
+    return p ? std::size_t(static_cast<const char*>(p) - hay) : PY_NPOS;
+}
+
+inline std::size_t pyFindScalar(const char* hay, std::size_t n, const char* needle, std::size_t k, std::size_t from) {
+    const char* p = hay + from;
+    const char* end = hay + n - k + 1;
+    while (p < end) {
+        p = static_cast<const char*>(std::memchr(p, needle[0], std::size_t(end - p)));
+        if (!p) {
+            return PY_NPOS;
+        }
+        if (std::memcmp(p + 1, needle + 1, k - 1) == 0) {
+            return std::size_t(p - hay);
+        }
+        ++p;
+    }
+    return PY_NPOS;
+}
+
+// Returns the byte offset of the first occurrence of needle, or PY_NPOS.
+inline std::size_t pyFind(const char* hay, std::size_t n, const char* needle, std::size_t k) {
+    if (k == 0) {
+        return 0;
+    }
+    if (k > n) {
+        return PY_NPOS;
+    }
+    if (k == 1) {
+        return pyFindByte(hay, n, needle[0]);
+    }
+    std::size_t i = 0;
+#ifdef __AVX2__
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+    for (; i + k - 1 + 32 <= n; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i + k - 1));
+        __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
+        for (uint32_t mask = uint32_t(_mm256_movemask_epi8(both)); mask != 0; mask &= mask - 1) {
+            std::size_t pos = i + std::size_t(__builtin_ctz(mask));
+            if (std::memcmp(hay + pos + 1, needle + 1, k - 2) == 0) {
+                return pos;
+            }
+        }
+    }
+#endif
+    return pyFindScalar(hay, n, needle, k, i);
+}
+
+// An empty needle matches at every byte offset, n + 1 times.
+inline std::size_t pyCount(const char* hay, std::size_t n, const char* needle, std::size_t k) {
+    std::size_t count = 0;
+    for (std::size_t pos = 0; pos <= n;) {
+        std::size_t found = pyFind(hay + pos, n - pos, needle, k);
+        if (found == PY_NPOS) {
+            break;
+        }
+        ++count;
+        pos += found + (k == 0 ? 1 : k);
+    }
+    return count;
+}
+
+inline bool pyIsSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r') || (c >= '\x1c' && c <= '\x1f');
+}
+
+#endif // PYSEARCH_H
@@ -0,0 +1,249 @@
+#ifndef PYSET_H
+#define PYSET_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PY_SET_SSE2 1
+#endif
+
+#include "pyhash.h"
+
+// Defined in pytuple.h, which includes this header through pystr.h; the
+// overloads for PyValue and PyStr are found when the repr is instantiated.
+template <class T>
+void pyRepr(std::ostream& os, const T& value);
+
+// A group of 16 control bytes. Each byte is EMPTY, DELETED, or the top 7
+// bits (h2) of the hash stored in the matching slot, so one compare tells
+// which of 16 slots may hold a key without touching the keys themselves.
+struct PyGroup {
+    static constexpr int kWidth = 16;
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    explicit PyGroup(const int8_t* ctrl) : ctrl(ctrl) {}
+
+#ifdef PY_SET_SSE2
+    uint32_t match(int8_t h2) const {
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), group)));
+    }
+    uint32_t matchEmpty() const { return match(EMPTY); }
+    // EMPTY and DELETED are the only control bytes with the sign bit set.
+    uint32_t matchEmptyOrDeleted() const {
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return uint32_t(_mm_movemask_epi8(group));
+    }
+#else
+    uint32_t match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (int i = 0; i < kWidth; ++i) {
+            mask |= uint32_t(ctrl[i] == h2) << i;
+        }
+        return mask;
+    }
+    uint32_t matchEmpty() const { return match(EMPTY); }
+    uint32_t matchEmptyOrDeleted() const {
+        uint32_t mask = 0;
+        for (int i = 0; i < kWidth; ++i) {
+            mask |= uint32_t(ctrl[i] < 0) << i;
+        }
+        return mask;
+    }
+#endif
+
+    const int8_t* ctrl;
+};
+
+inline int pyLowestBit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
+// Hash set probed SwissTable-style: the table is split into 16-slot groups
+// and probed a group at a time. Used for Python sets and hot `in` tests.
+template <class K, class Hash = PyHash<K>>
+class PySet {
+public:
+    class iterator {
+    public:
+        iterator(const PySet* set, std::size_t pos) : set(set), pos(pos) { skipFree(); }
+        const K& operator*() const { return set->slots[pos]; }
+        iterator& operator++() {
+            ++pos;
+            skipFree();
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+        bool operator==(const iterator& other) const { return pos == other.pos; }
+
+    private:
+        void skipFree() {
+            while (pos < set->capacity && set->ctrl[pos] < 0) {
+                ++pos;
+            }
+        }
+        const PySet* set;
+        std::size_t pos;
+    };
+
+    PySet() { rehash(PyGroup::kWidth); }
+    PySet(std::initializer_list<K> keys) : PySet() {
+        for (const K& key : keys) {
+            insert(key);
+        }
+    }
+
+    std::size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+    double loadFactor() const { return double(used) / double(capacity); }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, capacity); }
+
+    void reserve(std::size_t n) {
+        if (n > maxLoad(capacity)) {
+            rehash(capacityFor(n));
+        }
+    }
+
+    template <class Q>
+    bool contains(const Q& key) const { return findSlot(key, hashOf(key)) != kNotFound; }
+
+    bool insert(const K& key) {
+        uint64_t hash = hashOf(key);
+        if (findSlot(key, hash) != kNotFound) {
+            return false;
+        }
+        if (used + tombstones >= maxLoad(capacity)) {
+            rehash(used + 1 > maxLoad(capacity) ? capacity * 2 : capacity);
+        }
+        std::size_t slot = freeSlot(hash);
+        if (ctrl[slot] == PyGroup::DELETED) {
+            --tombstones;
+        }
+        ctrl[slot] = h2(hash);
+        slots[slot] = key;
+        ++used;
+        return true;
+    }
+
+    template <class Q>
+    bool erase(const Q& key) {
+        std::size_t slot = findSlot(key, hashOf(key));
+        if (slot == kNotFound) {
+            return false;
+        }
+        ctrl[slot] = PyGroup::DELETED;
+        slots[slot] = K();
+        --used;
+        ++tombstones;
+        return true;
+    }
+
+    void clear() {
+        used = 0;
+        rehash(PyGroup::kWidth);
+    }
+
+    // Python's repr: {a, b} in table order, or set() when empty.
+    friend std::ostream& operator<<(std::ostream& os, const PySet& set) {
+        if (set.empty()) {
+            return os << "set()";
+        }
+        os << '{';
+        for (iterator it = set.begin(); it != set.end(); ++it) {
+            os << (it == set.begin() ? "" : ", ");
+            pyRepr(os, *it);
+        }
+        return os << '}';
+    }
+
+private:
+    static constexpr std::size_t kNotFound = SIZE_MAX;
+
+    // Groups fill to 7/8 before the table grows.
+    static std::size_t maxLoad(std::size_t cap) { return cap - cap / 8; }
+
+    static std::size_t capacityFor(std::size_t n) {
+        std::size_t cap = PyGroup::kWidth;
+        while (maxLoad(cap) < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    template <class Q>
+    static uint64_t hashOf(const Q& key) { return pyMixHash(Hash()(key)); }
+    static int8_t h2(uint64_t hash) { return int8_t(hash >> 57); }
+
+    template <class Q>
+    std::size_t findSlot(const Q& key, uint64_t hash) const {
+        std::size_t groupMask = capacity / PyGroup::kWidth - 1;
+        std::size_t group = hash & groupMask;
+        int8_t tag = h2(hash);
+        for (std::size_t step = 1;; ++step) {
+            std::size_t base = group * PyGroup::kWidth;
+            PyGroup g(ctrl.data() + base);
+            for (uint32_t mask = g.match(tag); mask != 0; mask &= mask - 1) {
+                std::size_t slot = base + pyLowestBit(mask);
+                if (slots[slot] == key) {
+                    return slot;
+                }
+            }
+            if (g.matchEmpty() != 0) {
+                return kNotFound;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    std::size_t freeSlot(uint64_t hash) const {
+        std::size_t groupMask = capacity / PyGroup::kWidth - 1;
+        std::size_t group = hash & groupMask;
+        for (std::size_t step = 1;; ++step) {
+            std::size_t base = group * PyGroup::kWidth;
+            uint32_t mask = PyGroup(ctrl.data() + base).matchEmptyOrDeleted();
+            if (mask != 0) {
+                return base + pyLowestBit(mask);
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Also used at the same capacity to clear out tombstones.
+    void rehash(std::size_t newCapacity) {
+        std::vector<int8_t> oldCtrl = std::move(ctrl);
+        std::vector<K> oldSlots = std::move(slots);
+        capacity = newCapacity;
+        ctrl.assign(capacity, PyGroup::EMPTY);
+        slots.assign(capacity, K());
+        tombstones = 0;
+        for (std::size_t i = 0; i < oldCtrl.size(); ++i) {
+            if (oldCtrl[i] >= 0) {
+                uint64_t hash = hashOf(oldSlots[i]);
+                std::size_t slot = freeSlot(hash);
+                ctrl[slot] = h2(hash);
+                slots[slot] = std::move(oldSlots[i]);
+            }
+        }
+    }
+
+    std::vector<int8_t> ctrl;
+    std::vector<K> slots;
+    std::size_t capacity = 0;
+    std::size_t used = 0;
+    std::size_t tombstones = 0;
+};
+
+template <class K, class H, class Q>
+bool pyContains(const PySet<K, H>& set, const Q& key) {
+    return set.contains(key);
+}
+
+#endif // PYSET_H
@@ -0,0 +1,208 @@
+#ifndef PYSOA_H
+#define PYSOA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "pyvalue.h"
+
+// Structure-of-arrays storage for a list of lowered structs: one contiguous
+// column per field instead of one struct per element. A loop that touches
+// one or two fields then streams through dense arrays the compiler can
+// vectorize. Element access goes through a proxy (Ref) whose members are
+// references into the columns, so p.x reads and writes in place.
+
+template <class F>
+class PyColumn {
+public:
+    PyColumn() = default;
+    PyColumn(PyColumn&&) = default;
+    PyColumn& operator=(PyColumn&&) = default;
+    PyColumn(const PyColumn& other) { *this = other; }
+    PyColumn& operator=(const PyColumn& other) {
+        if (this != &other) {
+            count = 0;
+            reserve(other.count);
+            for (std::size_t i = 0; i < other.count; ++i) {
+                cells[i] = other.cells[i];
+            }
+            count = other.count;
+        }
+        return *this;
+    }
+
+    std::size_t size() const { return count; }
+    F* data() { return cells.get(); }
+    const F* data() const { return cells.get(); }
+    F* begin() { return data(); }
+    F* end() { return data() + count; }
+    const F* begin() const { return data(); }
+    const F* end() const { return data() + count; }
+    F& operator[](std::size_t i) { return cells[i]; }
+    const F& operator[](std::size_t i) const { return cells[i]; }
+
+    void reserve(std::size_t n) {
+        if (n <= capacity) {
+            return;
+        }
+        std::unique_ptr<F[]> grown(new F[n]);
+        for (std::size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(cells[i]);
+        }
+        cells = std::move(grown);
+        capacity = n;
+    }
+    void push_back(const F& value) {
+        if (count == capacity) {
+            reserve(capacity ? capacity * 2 : 8);
+        }
+        cells[count++] = value;
+    }
+    void pop_back() { cells[--count] = F(); }
+
+private:
+    // Not std::vector, so bool columns stay addressable.
+    std::unique_ptr<F[]> cells;
+    std::size_t count = 0;
+    std::size_t capacity = 0;
+};
+
+template <auto Member>
+struct PyMemberType;
+
+template <class T, class F, F T::*Member>
+struct PyMemberType<Member> {
+    using type = F;
+};
+
+template <auto A, auto B>
+constexpr bool pySameMember = false;
+
+template <auto A>
+constexpr bool pySameMember<A, A> = true;
+
+// T is the lowered struct, Ref the generated proxy (an aggregate of one
+// reference per field, in the order of Members).
+template <class T, class Ref, auto... Members>
+class PySoA {
+public:
+    class iterator {
+    public:
+        iterator(PySoA* soa, std::size_t i) : soa(soa), i(i) {}
+        Ref operator*() const { return soa->refAt(i); }
+        iterator& operator++() {
+            ++i;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return i != other.i; }
+
+    private:
+        PySoA* soa;
+        std::size_t i;
+    };
+
+    PySoA() = default;
+    // A list display of structs, [Particle(...), ...].
+    PySoA(std::initializer_list<T> values) {
+        reserve(values.size());
+        for (const T& value : values) {
+            append(value);
+        }
+    }
+
+    std::size_t size() const { return std::get<0>(columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    void reserve(std::size_t n) {
+        std::apply([n](auto&... column) { (column.reserve(n), ...); }, columns);
+    }
+    void append(const T& value) { appendFields(value, Indices()); }
+    void pop() {
+        if (empty()) {
+            throw std::out_of_range("IndexError: pop from empty list");
+        }
+        std::apply([](auto&... column) { (column.pop_back(), ...); }, columns);
+    }
+
+    Ref operator[](int64_t i) { return refAt(checkIndex(i)); }
+    Ref operator[](const PyValue& i) { return (*this)[i.asInt()]; }
+    // Gathers element i back into a struct.
+    T get(int64_t i) const { return gather(checkIndex(i), Indices()); }
+    void set(int64_t i, const T& value) { scatter(checkIndex(i), value, Indices()); }
+
+    // The dense array holding one field, e.g. particles.column<&Particle::x>().
+    template <auto Member>
+    auto& column() {
+        return std::get<indexOf<Member>()>(columns);
+    }
+    template <auto Member>
+    const auto& column() const {
+        return std::get<indexOf<Member>()>(columns);
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+
+    friend std::ostream& operator<<(std::ostream& os, const PySoA& soa) {
+        os << '[';
+        for (std::size_t i = 0; i < soa.size(); ++i) {
+            os << (i ? ", " : "") << soa.gather(i, Indices());
+        }
+        return os << ']';
+    }
+
+private:
+    using Indices = std::index_sequence_for<decltype(Members)...>;
+
+    template <auto Member>
+    static constexpr std::size_t indexOf() {
+        constexpr bool hits[] = {pySameMember<Member, Members>...};
+        std::size_t i = 0;
+        while (i < sizeof...(Members) && !hits[i]) {
+            ++i;
+        }
+        static_assert(((pySameMember<Member, Members>) || ...), "field is not stored in this PySoA");
+        return i;
+    }
+
+    template <std::size_t... Is>
+    void appendFields(const T& value, std::index_sequence<Is...>) {
+        (std::get<Is>(columns).push_back(value.*Members), ...);
+    }
+    template <std::size_t... Is>
+    T gather(std::size_t i, std::index_sequence<Is...>) const {
+        T value{};
+        ((value.*Members = std::get<Is>(columns)[i]), ...);
+        return value;
+    }
+    template <std::size_t... Is>
+    void scatter(std::size_t i, const T& value, std::index_sequence<Is...>) {
+        ((std::get<Is>(columns)[i] = value.*Members), ...);
+    }
+    Ref refAt(std::size_t i) { return refAt(i, Indices()); }
+    template <std::size_t... Is>
+    Ref refAt(std::size_t i, std::index_sequence<Is...>) {
+        return Ref{std::get<Is>(columns)[i]...};
+    }
+
+    std::size_t checkIndex(int64_t i) const {
+        int64_t n = int64_t(size());
+        if (i < 0) {
+            i += n;
+        }
+        if (i < 0 || i >= n) {
+            throw std::out_of_range("IndexError: list index out of range");
+        }
+        return std::size_t(i);
+    }
+
+    std::tuple<PyColumn<typename PyMemberType<Members>::type>...> columns;
+};
+
+#endif // PYSOA_H
@@ -0,0 +1,384 @@
+#ifndef PYSORT_H
+#define PYSORT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "pylist.h"
+#include "pyvalue.h"
+
+// list.sort() and sorted(). Boxed lists use a stable adaptive merge sort in
+// the style of CPython's: natural ascending or strictly descending runs are
+// found, short ones are extended by binary insertion, and runs are merged
+// in powersort order, so presorted and reversed input take one pass.
+// Unboxed int and float lists are radix sorted instead (stable, with NaN
+// falling back to comparisons). key= is called once per element, and
+// reverse keeps equal elements in their original order, as in Python.
+
+template <class T, class Less>
+class PyTimSort {
+public:
+    PyTimSort(T* data, Less less) : data(data), less(less) {}
+
+    void sort(std::size_t n) {
+        if (n < 2) {
+            return;
+        }
+        std::size_t minRun = minRunLength(n);
+        std::vector<Run> runs;
+        for (std::size_t lo = 0; lo < n;) {
+            std::size_t hi = countRun(lo, n);
+            if (hi - lo < minRun) {
+                std::size_t forced = std::min(n, lo + minRun);
+                insertionSort(lo, hi, forced);
+                hi = forced;
+            }
+            Run run{lo, hi, 0};
+            if (!runs.empty()) {
+                run.power = nodePower(runs.back().start, runs.back().end - runs.back().start, hi - lo, n);
+                while (runs.size() > 1 && runs.back().power > run.power) {
+                    mergeTop(runs);
+                }
+            }
+            runs.push_back(run);
+            lo = hi;
+        }
+        while (runs.size() > 1) {
+            mergeTop(runs);
+        }
+    }
+
+private:
+    struct Run {
+        std::size_t start;
+        std::size_t end;
+        int power;
+    };
+
+    // CPython's choice: n / 2^k rounded up, between 32 and 64, so the
+    // forced runs split n into a power of two or slightly fewer.
+    static std::size_t minRunLength(std::size_t n) {
+        std::size_t extra = 0;
+        while (n >= 64) {
+            extra |= n & 1;
+            n >>= 1;
+        }
+        return n + extra;
+    }
+
+    // Powersort: the depth of the boundary between two adjacent runs in a
+    // balanced binary tree over [0, n).
+    static int nodePower(std::size_t start1, std::size_t length1, std::size_t length2, std::size_t n) {
+        int power = 0;
+        std::size_t a = 2 * start1 + length1;
+        std::size_t b = a + length1 + length2;
+        for (;;) {
+            ++power;
+            if (a >= n) {
+                a -= n;
+                b -= n;
+            } else if (b >= n) {
+                break;
+            }
+            a <<= 1;
+            b <<= 1;
+        }
+        return power;
+    }
+
+    // End of the run starting at lo. A strictly descending run is reversed;
+    // it cannot contain equal elements, so stability is kept.
+    std::size_t countRun(std::size_t lo, std::size_t n) {
+        std::size_t hi = lo + 1;
+        if (hi == n) {
+            return hi;
+        }
+        if (less(data[hi], data[lo])) {
+            while (hi + 1 < n && less(data[hi + 1], data[hi])) {
+                ++hi;
+            }
+            std::reverse(data + lo, data + hi + 1);
+        } else {
+            while (hi + 1 < n && !less(data[hi + 1], data[hi])) {
+                ++hi;
+            }
+        }
+        return hi + 1;
+    }
+
+    // [lo, sorted) is ordered; inserts the rest up to hi. Each position is
+    // found before anything moves, so a throwing comparison loses nothing.
+    void insertionSort(std::size_t lo, std::size_t sorted, std::size_t hi) {
+        for (std::size_t i = sorted; i < hi; ++i) {
+            T* at = std::upper_bound(data + lo, data + i, data[i], less);
+            T pivot = std::move(data[i]);
+            std::move_backward(at, data + i, data + i + 1);
+            *at = std::move(pivot);
+        }
+    }
+
+    void mergeTop(std::vector<Run>& runs) {
+        Run right = runs.back();
+        runs.pop_back();
+        merge(runs.back().start, right.start, right.end);
+        runs.back().end = right.end;
+    }
+
+    void merge(std::size_t lo, std::size_t mid, std::size_t hi) {
+        if (!less(data[mid], data[mid - 1])) {
+            return;
+        }
+        // Elements already in place at either end take no part.
+        lo = std::size_t(std::upper_bound(data + lo, data + mid, data[mid], less) - data);
+        hi = std::size_t(std::lower_bound(data + mid, data + hi, data[mid - 1], less) - data);
+        if (mid - lo <= hi - mid) {
+            mergeForward(lo, mid, hi);
+        } else {
+            mergeBackward(lo, mid, hi);
+        }
+    }
+
+    // Moves the left run out and fills from the front. If a comparison
+    // throws, the buffered elements fill the gap, so the data stays a
+    // permutation.
+    void mergeForward(std::size_t lo, std::size_t mid, std::size_t hi) {
+        buffer.assign(std::make_move_iterator(data + lo), std::make_move_iterator(data + mid));
+        T* left = buffer.data();
+        T* leftEnd = left + buffer.size();
+        T* right = data + mid;
+        T* rightEnd = data + hi;
+        T* out = data + lo;
+        try {
+            while (left != leftEnd && right != rightEnd) {
+                if (less(*right, *left)) {
+                    *out++ = std::move(*right++);
+                } else {
+                    *out++ = std::move(*left++);
+                }
+            }
+        } catch (...) {
+            std::move(left, leftEnd, out);
+            throw;
+        }
+        std::move(left, leftEnd, out);
+    }
+
+    // Moves the right run out and fills from the back; equal elements take
+    // the right one first, which keeps them in order.
+    void mergeBackward(std::size_t lo, std::size_t mid, std::size_t hi) {
+        buffer.assign(std::make_move_iterator(data + mid), std::make_move_iterator(data + hi));
+        T* left = data + mid;
+        T* leftBegin = data + lo;
+        T* right = buffer.data() + buffer.size();
+        T* rightBegin = buffer.data();
+        T* out = data + hi;
+        try {
+            while (left != leftBegin && right != rightBegin) {
+                if (less(*(right - 1), *(left - 1))) {
+                    *--out = std::move(*--left);
+                } else {
+                    *--out = std::move(*--right);
+                }
+            }
+        } catch (...) {
+            std::move(rightBegin, right, left);
+            throw;
+        }
+        std::move(rightBegin, right, left);
+    }
+
+    T* data;
+    Less less;
+    std::vector<T> buffer;
+};
+
+template <class T, class Less>
+void pyTimSort(T* data, std::size_t n, Less less) {
+    PyTimSort<T, Less>(data, less).sort(n);
+}
+
+// Stable LSD radix sort on the unsigned key of each item, a byte per pass.
+// Passes where every item has the same byte are skipped.
+template <class T, class Key>
+void pyRadixSort(std::vector<T>& items, Key key) {
+    std::size_t n = items.size();
+    std::vector<std::size_t> counts(8 * 256, 0);
+    for (const T& item : items) {
+        uint64_t k = key(item);
+        for (std::size_t pass = 0; pass < 8; ++pass) {
+            ++counts[pass * 256 + ((k >> (8 * pass)) & 0xFF)];
+        }
+    }
+    std::vector<T> buffer(n);
+    for (std::size_t pass = 0; pass < 8; ++pass) {
+        std::size_t* count = counts.data() + pass * 256;
+        if (count[(key(items[0]) >> (8 * pass)) & 0xFF] == n) {
+            continue;
+        }
+        std::size_t offset = 0;
+        for (std::size_t b = 0; b < 256; ++b) {
+            std::size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (const T& item : items) {
+            buffer[count[(key(item) >> (8 * pass)) & 0xFF]++] = item;
+        }
+        items.swap(buffer);
+    }
+}
+
+// Below this size a comparison sort beats building the histograms.
+const std::size_t PY_RADIX_MIN = 256;
+
+// Handles input that is already ascending, or strictly descending, in one
+// pass; radix sort would not notice. Returns false if it is neither.
+template <class T>
+bool pySortMonotonic(std::vector<T>& items) {
+    std::size_t ascending = 0;
+    std::size_t descending = 0;
+    for (std::size_t i = 1; i < items.size(); ++i) {
+        ascending += !(items[i] < items[i - 1]);
+        descending += items[i] < items[i - 1];
+    }
+    if (descending == 0) {
+        return true;
+    }
+    if (ascending == 0) {
+        std::reverse(items.begin(), items.end());
+        return true;
+    }
+    return false;
+}
+
+inline void pySortInts(std::vector<int64_t>& items) {
+    if (items.size() < PY_RADIX_MIN) {
+        std::sort(items.begin(), items.end());
+        return;
+    }
+    if (pySortMonotonic(items)) {
+        return;
+    }
+    pyRadixSort(items, [](int64_t v) { return uint64_t(v) ^ (uint64_t(1) << 63); });
+}
+
+inline void pySortFloats(std::vector<double>& items) {
+    bool hasNaN = false;
+    for (double v : items) {
+        hasNaN |= std::isnan(v);
+    }
+    if (hasNaN || items.size() < PY_RADIX_MIN) {
+        pyTimSort(items.data(), items.size(), [](double a, double b) { return a < b; });
+        return;
+    }
+    if (pySortMonotonic(items)) {
+        return;
+    }
+    // Flips negatives so the bit patterns order like the values; -0.0 keys
+    // as 0.0 because the two compare equal.
+    pyRadixSort(items, [](double v) {
+        uint64_t bits;
+        double d = v == 0.0 ? 0.0 : v;
+        std::memcpy(&bits, &d, sizeof bits);
+        return bits >> 63 ? ~bits : bits | (uint64_t(1) << 63);
+    });
+}
+
+inline void pySort(PyList& list, bool reverse = false) {
+    // Sorting the reversed list and reversing the result keeps equal
+    // elements in their original order.
+    switch (list.storage()) {
+        case PyList::INTS:
+            // Equal ints are indistinguishable, so no reversal is needed first.
+            pySortInts(list.ints());
+            if (reverse) {
+                std::reverse(list.ints().begin(), list.ints().end());
+            }
+            break;
+        case PyList::FLOATS:
+            if (reverse) {
+                std::reverse(list.floats().begin(), list.floats().end());
+            }
+            pySortFloats(list.floats());
+            if (reverse) {
+                std::reverse(list.floats().begin(), list.floats().end());
+            }
+            break;
+        case PyList::GENERIC: {
+            std::vector<PyValue>& items = list.values();
+            if (reverse) {
+                std::reverse(items.begin(), items.end());
+            }
+            pyTimSort(items.data(), items.size(), [](const PyValue& a, const PyValue& b) { return a < b; });
+            if (reverse) {
+                std::reverse(items.begin(), items.end());
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Sorts by key(item), computing each key once; the list is only rewritten
+// after every key and comparison has succeeded.
+template <class Key>
+void pySort(PyList& list, Key key, bool reverse) {
+    std::size_t n = list.size();
+    std::vector<PyValue> keys;
+    keys.reserve(n);
+    for (PyValue item : list) {
+        keys.push_back(PyValue(key(item)));
+    }
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    if (reverse) {
+        std::reverse(order.begin(), order.end());
+    }
+    pyTimSort(order.data(), n, [&keys](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+    if (reverse) {
+        std::reverse(order.begin(), order.end());
+    }
+    PyList sorted;
+    sorted.reserve(n);
+    for (std::size_t i : order) {
+        sorted.append(list[int64_t(i)]);
+    }
+    list = std::move(sorted);
+}
+
+template <class Iterable, PyIfNotList<Iterable> = 0>
+PyList pyListOf(Iterable&& items) {
+    PyList list;
+    for (const auto& item : items) {
+        list.append(PyValue(item));
+    }
+    return list;
+}
+
+inline PyList pyListOf(const PyList& items) {
+    return items;
+}
+
+template <class Iterable>
+PyList pySorted(Iterable&& items, bool reverse = false) {
+    PyList list = pyListOf(std::forward<Iterable>(items));
+    pySort(list, reverse);
+    return list;
+}
+
+template <class Iterable, class Key>
+PyList pySorted(Iterable&& items, Key key, bool reverse) {
+    PyList list = pyListOf(std::forward<Iterable>(items));
+    pySort(list, key, reverse);
+    return list;
+}
+
+#endif // PYSORT_H
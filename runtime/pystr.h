@@ -0,0 +1,475 @@
+#ifndef PYSTR_H
+#define PYSTR_H
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pydict.h"
+#include "pyhash.h"
+#include "pyobject.h"
+#include "pysearch.h"
+
+// Immutable Python str over UTF-8 bytes. The code-point length and an
+// is-ASCII flag are computed once at construction, so len() is O(1) and
+// indexing an ASCII string is a byte load. Strings of up to 16 bytes are
+// stored inline; longer ones share a refcounted heap buffer.
+
+struct PyStrData : PyObject {
+    explicit PyStrData(std::string_view s) : bytes(s) {}
+    explicit PyStrData(std::string&& s) : bytes(std::move(s)) {}
+    std::string bytes;
+    // Byte offset of every kCheckpointStride-th code point, built on the
+    // first index into a non-ASCII string.
+    std::once_flag indexed;
+    std::vector<uint32_t> checkpoints;
+};
+
+class PyStr {
+public:
+    static constexpr std::size_t kInlineCapacity = 16;
+    static constexpr std::size_t kCheckpointStride = 32;
+
+    PyStr() : byteLen(0), charLen(0), ascii(true), storage{} {}
+    PyStr(std::string_view s) : storage{} { init(s); }
+    PyStr(const char* s) : PyStr(std::string_view(s)) {}
+    PyStr(const std::string& s) : PyStr(std::string_view(s)) {}
+
+    PyStr(const PyStr& other) : byteLen(other.byteLen), charLen(other.charLen), ascii(other.ascii), storage(other.storage) {
+        if (!isInline()) {
+            pyIncRef(storage.heap);
+        }
+    }
+    PyStr(PyStr&& other) noexcept : byteLen(other.byteLen), charLen(other.charLen), ascii(other.ascii), storage(other.storage) {
+        other.byteLen = 0;
+        other.charLen = 0;
+        other.ascii = true;
+    }
+    PyStr& operator=(PyStr other) noexcept {
+        std::swap(byteLen, other.byteLen);
+        std::swap(charLen, other.charLen);
+        std::swap(ascii, other.ascii);
+        std::swap(storage, other.storage);
+        return *this;
+    }
+    ~PyStr() {
+        if (!isInline()) {
+            pyDecRef(storage.heap);
+        }
+    }
+
+    // Returns the single shared copy of a string. Generated code interns
+    // every literal once through PY_LITERAL.
+    static const PyStr& intern(std::string_view s) {
+        static std::mutex lock;
+        static PyDict<std::string, PyStr*>* table = new PyDict<std::string, PyStr*>();
+        std::lock_guard<std::mutex> guard(lock);
+        if (PyStr** found = table->find(s)) {
+            return **found;
+        }
+        PyStr* str = new PyStr(s);
+        str->share();
+        (*table)[std::string(s)] = str;
+        return *str;
+    }
+
+    // Switches the buffer to atomic reference counting before the string
+    // is handed to another thread.
+    void share() const {
+        if (!isInline()) {
+            pyShare(storage.heap);
+        }
+    }
+
+    std::size_t size() const { return charLen; }
+    std::size_t byteSize() const { return byteLen; }
+    bool empty() const { return byteLen == 0; }
+    bool isAscii() const { return ascii; }
+    const char* data() const { return isInline() ? storage.small : storage.heap->bytes.data(); }
+    std::string_view view() const { return std::string_view(data(), byteLen); }
+    std::string str() const { return std::string(view()); }
+    operator std::string_view() const { return view(); }
+
+    PyStr operator[](int64_t i) const {
+        if (i < 0) {
+            i += int64_t(charLen);
+        }
+        if (i < 0 || i >= int64_t(charLen)) {
+            throw std::out_of_range("IndexError: string index out of range");
+        }
+        if (ascii) {
+            return PyStr(view().substr(std::size_t(i), 1));
+        }
+        std::size_t begin = byteOffset(std::size_t(i));
+        return PyStr(view().substr(begin, sequenceLength(begin)));
+    }
+
+    // s[start:stop], with Python's clamping of out-of-range bounds.
+    PyStr slice(int64_t start, int64_t stop) const {
+        int64_t len = int64_t(charLen);
+        start = clampIndex(start, len);
+        stop = clampIndex(stop, len);
+        if (start >= stop) {
+            return PyStr();
+        }
+        std::size_t begin = byteOffset(std::size_t(start));
+        std::size_t end = byteOffset(std::size_t(stop));
+        return PyStr(view().substr(begin, end - begin));
+    }
+
+    // Python's find(): a code-point index, or -1.
+    int64_t find(std::string_view sub) const {
+        std::size_t pos = pyFind(data(), byteLen, sub.data(), sub.size());
+        if (pos == PY_NPOS) {
+            return -1;
+        }
+        return int64_t(ascii ? pos : countCodePoints(view().substr(0, pos)));
+    }
+    bool contains(std::string_view sub) const {
+        return pyFind(data(), byteLen, sub.data(), sub.size()) != PY_NPOS;
+    }
+    // An empty sub matches between code points, not bytes.
+    std::size_t count(std::string_view sub) const {
+        if (sub.empty()) {
+            return charLen + 1;
+        }
+        return pyCount(data(), byteLen, sub.data(), sub.size());
+    }
+
+    // The views point into this string and stay valid while it is alive and
+    // unmodified, so they suit parts that are only read, not kept.
+    std::vector<std::string_view> splitViews(std::string_view sep) const {
+        if (sep.empty()) {
+            throw std::invalid_argument("ValueError: empty separator");
+        }
+        std::vector<std::string_view> parts;
+        std::string_view rest = view();
+        while (true) {
+            std::size_t pos = pyFind(rest.data(), rest.size(), sep.data(), sep.size());
+            if (pos == PY_NPOS) {
+                break;
+            }
+            parts.push_back(rest.substr(0, pos));
+            rest.remove_prefix(pos + sep.size());
+        }
+        parts.push_back(rest);
+        return parts;
+    }
+    // split() with no separator: runs of whitespace, no empty parts.
+    std::vector<std::string_view> splitViews() const {
+        std::vector<std::string_view> parts;
+        std::string_view v = view();
+        std::size_t i = 0;
+        while (true) {
+            while (i < v.size() && pyIsSpace(v[i])) {
+                ++i;
+            }
+            if (i == v.size()) {
+                break;
+            }
+            std::size_t start = i;
+            while (i < v.size() && !pyIsSpace(v[i])) {
+                ++i;
+            }
+            parts.push_back(v.substr(start, i - start));
+        }
+        return parts;
+    }
+    std::vector<PyStr> split(std::string_view sep) const { return toStrs(splitViews(sep)); }
+    std::vector<PyStr> split() const { return toStrs(splitViews()); }
+
+    // sep.join(parts): one pass to size the result, one allocation, and the
+    // code-point length is summed from the parts instead of rescanned.
+    template <class Container>
+    PyStr join(const Container& parts) const {
+        std::size_t bytes = 0;
+        std::size_t chars = 0;
+        std::size_t n = 0;
+        bool allAscii = true;
+        for (const auto& part : parts) {
+            measure(part, bytes, chars, allAscii);
+            ++n;
+        }
+        if (n > 1) {
+            bytes += byteLen * (n - 1);
+            chars += charLen * (n - 1);
+            allAscii = allAscii && ascii;
+        }
+        std::string out;
+        out.reserve(bytes);
+        bool first = true;
+        for (const auto& part : parts) {
+            if (!first) {
+                out.append(view());
+            }
+            out.append(partView(part));
+            first = false;
+        }
+        return adopt(std::move(out), chars, allAscii);
+    }
+
+    PyStr replace(std::string_view old, std::string_view repl, int64_t count = -1) const {
+        std::vector<std::size_t> hits;
+        std::string_view v = view();
+        for (std::size_t pos = 0; pos <= v.size() && (count < 0 || int64_t(hits.size()) < count);) {
+            std::size_t found = old.empty() ? pos : pyFind(v.data() + pos, v.size() - pos, old.data(), old.size());
+            if (found == PY_NPOS) {
+                break;
+            }
+            found = old.empty() ? pos : pos + found;
+            hits.push_back(found);
+            // An empty pattern matches at every code-point boundary.
+            pos = found + (old.empty() ? (found < v.size() ? sequenceLength(found) : 1) : old.size());
+        }
+        if (hits.empty()) {
+            return *this;
+        }
+        std::string out;
+        out.reserve(v.size() + hits.size() * repl.size() - hits.size() * old.size());
+        std::size_t last = 0;
+        for (std::size_t hit : hits) {
+            out.append(v.substr(last, hit - last));
+            out.append(repl);
+            last = hit + old.size();
+        }
+        out.append(v.substr(last));
+        std::size_t oldChars = countCodePoints(old);
+        std::size_t replChars = countCodePoints(repl);
+        std::size_t chars = charLen + hits.size() * replChars - hits.size() * oldChars;
+        if (ascii && isAsciiView(repl)) {
+            return adopt(std::move(out), chars, true);
+        }
+        return adopt(std::move(out), chars, isAsciiView(out));
+    }
+
+    PyStr strip() const { return stripWhitespace(true, true); }
+    PyStr lstrip() const { return stripWhitespace(true, false); }
+    PyStr rstrip() const { return stripWhitespace(false, true); }
+    PyStr strip(std::string_view chars) const { return stripChars(chars, true, true); }
+    PyStr lstrip(std::string_view chars) const { return stripChars(chars, true, false); }
+    PyStr rstrip(std::string_view chars) const { return stripChars(chars, false, true); }
+
+    friend PyStr operator+(const PyStr& a, const PyStr& b) {
+        std::string joined;
+        joined.reserve(a.byteLen + b.byteLen);
+        joined.append(a.view());
+        joined.append(b.view());
+        return adopt(std::move(joined), a.charLen + b.charLen, a.ascii && b.ascii);
+    }
+    friend bool operator==(const PyStr& a, const PyStr& b) {
+        if (a.byteLen != b.byteLen) {
+            return false;
+        }
+        if (!a.isInline() && a.storage.heap == b.storage.heap) {
+            return true;
+        }
+        return std::memcmp(a.data(), b.data(), a.byteLen) == 0;
+    }
+    friend bool operator!=(const PyStr& a, const PyStr& b) { return !(a == b); }
+    // UTF-8 byte order matches code-point order.
+    friend bool operator<(const PyStr& a, const PyStr& b) { return a.view() < b.view(); }
+    friend std::ostream& operator<<(std::ostream& os, const PyStr& s) { return os << s.view(); }
+
+private:
+    bool isInline() const { return byteLen <= kInlineCapacity; }
+
+    // Takes ownership of bytes whose length and ASCII-ness are already known.
+    static PyStr adopt(std::string&& bytes, std::size_t chars, bool isAscii) {
+        PyStr s;
+        s.byteLen = uint32_t(bytes.size());
+        s.charLen = uint32_t(chars);
+        s.ascii = isAscii;
+        if (s.isInline()) {
+            std::memcpy(s.storage.small, bytes.data(), bytes.size());
+        } else {
+            s.storage.heap = new PyStrData(std::move(bytes));
+        }
+        return s;
+    }
+
+    static std::size_t countCodePoints(std::string_view s) {
+        std::size_t n = 0;
+        for (unsigned char c : s) {
+            n += (c & 0xC0) != 0x80;
+        }
+        return n;
+    }
+    static bool isAsciiView(std::string_view s) {
+        uint8_t high = 0;
+        for (unsigned char c : s) {
+            high |= c;
+        }
+        return high < 0x80;
+    }
+
+    std::vector<PyStr> toStrs(const std::vector<std::string_view>& views) const {
+        std::vector<PyStr> strs;
+        strs.reserve(views.size());
+        for (std::string_view part : views) {
+            strs.push_back(ascii ? adopt(std::string(part), part.size(), true) : PyStr(part));
+        }
+        return strs;
+    }
+
+    static void measure(const PyStr& part, std::size_t& bytes, std::size_t& chars, bool& allAscii) {
+        bytes += part.byteLen;
+        chars += part.charLen;
+        allAscii = allAscii && part.ascii;
+    }
+    static void measure(std::string_view part, std::size_t& bytes, std::size_t& chars, bool& allAscii) {
+        bytes += part.size();
+        chars += countCodePoints(part);
+        allAscii = allAscii && isAsciiView(part);
+    }
+    static void measure(const std::string& part, std::size_t& bytes, std::size_t& chars, bool& allAscii) {
+        measure(std::string_view(part), bytes, chars, allAscii);
+    }
+    static std::string_view partView(const PyStr& part) { return part.view(); }
+    static std::string_view partView(std::string_view part) { return part; }
+    static std::string_view partView(const std::string& part) { return part; }
+
+    PyStr stripWhitespace(bool left, bool right) const {
+        std::string_view v = view();
+        std::size_t begin = 0;
+        std::size_t end = v.size();
+        while (left && begin < end && pyIsSpace(v[begin])) {
+            ++begin;
+        }
+        while (right && end > begin && pyIsSpace(v[end - 1])) {
+            --end;
+        }
+        return substrBytes(begin, end);
+    }
+
+    // Strips whole code points, so multi-byte characters in chars work.
+    PyStr stripChars(std::string_view chars, bool left, bool right) const {
+        std::string_view v = view();
+        std::size_t begin = 0;
+        std::size_t end = v.size();
+        while (left && begin < end) {
+            std::size_t len = sequenceLength(begin);
+            if (pyFind(chars.data(), chars.size(), v.data() + begin, len) == PY_NPOS) {
+                break;
+            }
+            begin += len;
+        }
+        while (right && end > begin) {
+            std::size_t start = end - 1;
+            while (start > begin && (uint8_t(v[start]) & 0xC0) == 0x80) {
+                --start;
+            }
+            if (pyFind(chars.data(), chars.size(), v.data() + start, end - start) == PY_NPOS) {
+                break;
+            }
+            end = start;
+        }
+        return substrBytes(begin, end);
+    }
+
+    PyStr substrBytes(std::size_t begin, std::size_t end) const {
+        if (begin == 0 && end == byteLen) {
+            return *this;
+        }
+        std::string_view part = view().substr(begin, end - begin);
+        return ascii ? adopt(std::string(part), part.size(), true) : PyStr(part);
+    }
+
+    void init(std::string_view s) {
+        if (s.size() > UINT32_MAX) {
+            throw std::length_error("MemoryError: string too long");
+        }
+        byteLen = uint32_t(s.size());
+        charLen = 0;
+        uint8_t high = 0;
+        for (unsigned char c : s) {
+            high |= c;
+            charLen += (c & 0xC0) != 0x80;
+        }
+        ascii = high < 0x80;
+        if (isInline()) {
+            std::memcpy(storage.small, s.data(), s.size());
+        } else {
+            storage.heap = new PyStrData(s);
+        }
+    }
+
+    static int64_t clampIndex(int64_t i, int64_t len) {
+        if (i < 0) {
+            i += len;
+        }
+        return i < 0 ? 0 : i > len ? len : i;
+    }
+
+    std::size_t sequenceLength(std::size_t offset) const {
+        std::size_t end = offset + 1;
+        while (end < byteLen && (uint8_t(data()[end]) & 0xC0) == 0x80) {
+            ++end;
+        }
+        return end - offset;
+    }
+
+    // Walks forward from the nearest checkpoint; short strings just scan.
+    std::size_t byteOffset(std::size_t cp) const {
+        if (ascii || cp >= charLen) {
+            return ascii ? cp : byteLen;
+        }
+        const char* bytes = data();
+        std::size_t offset = 0;
+        std::size_t remaining = cp;
+        if (!isInline()) {
+            PyStrData* heap = storage.heap;
+            std::call_once(heap->indexed, [this, heap] { buildCheckpoints(heap); });
+            offset = heap->checkpoints[cp / kCheckpointStride];
+            remaining = cp % kCheckpointStride;
+        }
+        while (true) {
+            if ((uint8_t(bytes[offset]) & 0xC0) != 0x80) {
+                if (remaining == 0) {
+                    return offset;
+                }
+                --remaining;
+            }
+            ++offset;
+        }
+    }
+
+    void buildCheckpoints(PyStrData* heap) const {
+        std::size_t cp = 0;
+        for (std::size_t i = 0; i < byteLen; ++i) {
+            if ((uint8_t(heap->bytes[i]) & 0xC0) != 0x80) {
+                if (cp % kCheckpointStride == 0) {
+                    heap->checkpoints.push_back(uint32_t(i));
+                }
+                ++cp;
+            }
+        }
+    }
+
+    uint32_t byteLen;
+    uint32_t charLen;
+    bool ascii;
+    union Storage {
+        char small[kInlineCapacity];
+        PyStrData* heap;
+    } storage;
+};
+
+template <>
+struct PyHash<PyStr> {
+    uint64_t operator()(std::string_view s) const { return PyHash<std::string>()(s); }
+};
+
+template <class Q>
+bool pyContains(const PyStr& s, const Q& sub) {
+    return s.contains(sub);
+}
+
+// Interns a string literal once per call site.
+#define PY_LITERAL(text) ([]() -> const PyStr& { static const PyStr& s = PyStr::intern(text); return s; }())
+
+#endif // PYSTR_H
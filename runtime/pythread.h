@@ -0,0 +1,307 @@
+#ifndef PYTHREAD_H
+#define PYTHREAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pyobject.h"
+
+// threading and concurrent.futures on native threads. There is no global
+// lock: translated code runs truly in parallel and, as in free-threaded
+// Python, a read-modify-write of shared data needs a PyLock. Values crossing
+// a thread boundary here (thread arguments, submitted arguments, results)
+// are marked shared, which turns on atomic reference counting for those
+// objects only. Threads can also reach objects that never cross, such as
+// module globals, so translated programs that start threads call
+// pyEnableThreads() before main.
+
+template <class T>
+auto pyShareArg(const T& value, int) -> decltype(value.share(), void()) {
+    value.share();
+}
+
+template <class T>
+void pyShareArg(const T&, long) {}
+
+template <class... Args>
+void pyShareArgs(const Args&... args) {
+    (pyShareArg(args, 0), ...);
+}
+
+// threading.Lock. Also BasicLockable, so `with lock:` is a std::lock_guard.
+class PyLock {
+public:
+    void acquire() { mutex.lock(); }
+    bool acquire(bool blocking) {
+        if (blocking) {
+            mutex.lock();
+            return true;
+        }
+        return mutex.try_lock();
+    }
+    void release() { mutex.unlock(); }
+
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+
+private:
+    std::mutex mutex;
+};
+
+// threading.Thread(target=f, args=(...)). Like a non-daemon Python thread,
+// an unjoined thread is joined when the object goes away.
+class PyThread {
+public:
+    template <class F, class... Args>
+    explicit PyThread(F target, Args... args) {
+        pyShareArgs(args...);
+        body = [target = std::move(target), args = std::make_tuple(std::move(args)...)]() mutable {
+            try {
+                std::apply(target, args);
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in thread: " << e.what() << std::endl;
+            }
+        };
+    }
+    PyThread(const PyThread&) = delete;
+    PyThread& operator=(const PyThread&) = delete;
+    ~PyThread() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void start() {
+        if (started) {
+            throw std::runtime_error("RuntimeError: threads can only be started once");
+        }
+        started = true;
+        thread = std::thread(std::move(body));
+    }
+    void join() {
+        if (!started) {
+            throw std::runtime_error("RuntimeError: cannot join thread before it is started");
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    bool isAlive() const { return started && thread.joinable(); }
+
+private:
+    std::function<void()> body;
+    std::thread thread;
+    bool started = false;
+};
+
+class PyThreadPoolExecutor;
+
+// concurrent.futures.Future. result() waits, rethrowing the task's
+// exception. A pool worker that waits on a future runs other queued tasks
+// meanwhile, so tasks that submit and wait on subtasks cannot starve the
+// pool.
+template <class T>
+class PyFuture {
+public:
+    PyFuture(std::shared_future<T> future, PyThreadPoolExecutor* pool) : future(std::move(future)), pool(pool) {}
+
+    bool done() const { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    T result() const;
+
+private:
+    std::shared_future<T> future;
+    PyThreadPoolExecutor* pool;
+};
+
+// concurrent.futures.ThreadPoolExecutor with work stealing. Each worker
+// owns a deque: it takes its own newest task (cache-warm) and steals the
+// oldest task from another worker when it runs dry. Tasks submitted from a
+// worker go to that worker's deque; tasks from outside are dealt round
+// robin.
+class PyThreadPoolExecutor {
+public:
+    explicit PyThreadPoolExecutor(std::size_t maxWorkers = 0) {
+        if (maxWorkers == 0) {
+            maxWorkers = std::min<std::size_t>(32, std::thread::hardware_concurrency() + 4);
+        }
+        queues = std::vector<Queue>(maxWorkers);
+        for (std::size_t i = 0; i < maxWorkers; ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+    PyThreadPoolExecutor(const PyThreadPoolExecutor&) = delete;
+    PyThreadPoolExecutor& operator=(const PyThreadPoolExecutor&) = delete;
+    ~PyThreadPoolExecutor() { shutdown(); }
+
+    template <class F, class... Args>
+    auto submit(F fn, Args... args) -> PyFuture<std::invoke_result_t<F&, Args&...>> {
+        using R = std::invoke_result_t<F&, Args&...>;
+        if (stopping) {
+            throw std::runtime_error("RuntimeError: cannot schedule new futures after shutdown");
+        }
+        pyShareArgs(args...);
+        auto task = std::make_shared<std::packaged_task<R()>>(
+            [fn = std::move(fn), args = std::make_tuple(std::move(args)...)]() mutable -> R {
+                if constexpr (std::is_void_v<R>) {
+                    std::apply(fn, args);
+                } else {
+                    R result = std::apply(fn, args);
+                    pyShareArg(result, 0);
+                    return result;
+                }
+            });
+        PyFuture<R> future(task->get_future().share(), this);
+        push([task] { (*task)(); });
+        return future;
+    }
+
+    // Executor.map, collected eagerly: results come back in input order.
+    template <class F, class Iterable>
+    auto map(F fn, const Iterable& items) {
+        using R = std::invoke_result_t<F&, decltype(*std::begin(items))>;
+        std::vector<PyFuture<R>> futures;
+        for (const auto& item : items) {
+            futures.push_back(submit(fn, item));
+        }
+        std::vector<R> results;
+        results.reserve(futures.size());
+        for (const auto& future : futures) {
+            results.push_back(future.result());
+        }
+        return results;
+    }
+
+    // Waits for queued tasks to finish, then stops the workers.
+    void shutdown() {
+        if (stopping.exchange(true)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::size_t size() const { return workers.size(); }
+
+    // Runs one queued task on the calling worker; false if there was none.
+    bool runOne() {
+        std::function<void()> task;
+        if (!take(currentIndex(), task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    // True when called from one of this pool's workers.
+    bool isWorker() const { return current().pool == this; }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+    struct WorkerSlot {
+        const PyThreadPoolExecutor* pool = nullptr;
+        std::size_t index = 0;
+    };
+
+    static WorkerSlot& current() {
+        thread_local WorkerSlot slot;
+        return slot;
+    }
+    std::size_t currentIndex() const { return isWorker() ? current().index : 0; }
+
+    void push(std::function<void()> task) {
+        std::size_t target = isWorker() ? current().index : nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> guard(queues[target].lock);
+            queues[target].tasks.push_back(std::move(task));
+        }
+        pending.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+        }
+        wake.notify_one();
+    }
+
+    bool take(std::size_t self, std::function<void()>& task) {
+        if (pending.load() == 0) {
+            return false;
+        }
+        for (std::size_t k = 0; k < queues.size(); ++k) {
+            std::size_t victim = (self + k) % queues.size();
+            std::lock_guard<std::mutex> guard(queues[victim].lock);
+            std::deque<std::function<void()>>& tasks = queues[victim].tasks;
+            if (tasks.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+            } else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            pending.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void work(std::size_t index) {
+        current() = WorkerSlot{this, index};
+        std::function<void()> task;
+        for (;;) {
+            if (take(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            wake.wait(guard, [this] { return pending.load() > 0 || stopping; });
+            if (stopping && pending.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> pending{0};
+    std::atomic<std::size_t> nextQueue{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+};
+
+template <class T>
+T PyFuture<T>::result() const {
+    while (pool && pool->isWorker() && !done()) {
+        if (!pool->runOne()) {
+            std::this_thread::yield();
+        }
+    }
+    return future.get();
+}
+
+#endif // PYTHREAD_H
@@ -0,0 +1,146 @@
+#ifndef PYTUPLE_H
+#define PYTUPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "pyhash.h"
+#include "pyint.h"
+#include "pystr.h"
+#include "pyvalue.h"
+
+// Tuples of known arity are plain std::tuples: fields sit at fixed offsets
+// and need no boxing. Classes lowered to structs print their fields through
+// pyRepr so the output matches Python's repr().
+
+template <class... Ts>
+using PyTuple = std::tuple<Ts...>;
+
+template <class T>
+void pyRepr(std::ostream& os, const T& value) {
+    os << value;
+}
+
+inline void pyRepr(std::ostream& os, bool value) {
+    os << (value ? "True" : "False");
+}
+
+inline void pyRepr(std::ostream& os, double value) {
+    os << PyValue(value);
+}
+
+inline void pyRepr(std::ostream& os, const PyStr& value) {
+    os << '\'' << value << '\'';
+}
+
+inline void pyRepr(std::ostream& os, const PyValue& value) {
+    if (value.isStr()) {
+        pyRepr(os, value.asStr());
+    } else {
+        os << value;
+    }
+}
+
+template <class... Ts>
+void pyRepr(std::ostream& os, const std::tuple<Ts...>& t) {
+    os << '(';
+    std::apply([&os](const auto&... fields) {
+        std::size_t i = 0;
+        ((os << (i++ ? ", " : ""), pyRepr(os, fields)), ...);
+    }, t);
+    os << (sizeof...(Ts) == 1 ? ",)" : ")");
+}
+
+// A tuple inside a PyValue, e.g. an item of zip() collected by sorted().
+struct PyBoxedTuple : PyBoxedContainer {
+    void shareChildren() override {
+        for (const PyValue& item : items) {
+            item.share();
+        }
+    }
+    std::size_t length() const override { return items.size(); }
+    PyValue item(std::size_t i) const override { return items[i]; }
+    std::string repr() const override {
+        std::ostringstream os;
+        os << '(';
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            os << (i ? ", " : "");
+            pyRepr(os, items[i]);
+        }
+        os << (items.size() == 1 ? ",)" : ")");
+        return os.str();
+    }
+    std::vector<PyValue> items;
+};
+
+template <class... Ts>
+PyValue::PyValue(const std::tuple<Ts...>& tuple) {
+    PyBoxedTuple* boxed = new PyBoxedTuple;
+    std::apply([boxed](const auto&... fields) { (boxed->items.push_back(PyValue(fields)), ...); }, tuple);
+    bits = boxObject(boxed);
+}
+
+template <class... Ts>
+std::ostream& operator<<(std::ostream& os, const std::tuple<Ts...>& t) {
+    pyRepr(os, t);
+    return os;
+}
+
+template <class... Ts>
+PyValue pyLen(const std::tuple<Ts...>&) {
+    return PyValue(int64_t(sizeof...(Ts)));
+}
+
+// Constructor arguments arrive boxed; struct fields of unboxed types take
+// them back out. A float field converts an int it is given, where Python
+// would keep the int.
+template <class T>
+T pyUnbox(const PyValue& value);
+
+template <>
+inline double pyUnbox<double>(const PyValue& value) {
+    return value.isFloat() ? value.asFloat() : double(value.asInt());
+}
+
+template <>
+inline bool pyUnbox<bool>(const PyValue& value) {
+    return value.truthy();
+}
+
+template <>
+inline PyInt pyUnbox<PyInt>(const PyValue& value) {
+    return value.asPyInt();
+}
+
+template <>
+inline PyStr pyUnbox<PyStr>(const PyValue& value) {
+    return value.asStr();
+}
+
+template <class... Ts>
+struct PyHash<std::tuple<Ts...>> {
+    uint64_t operator()(const std::tuple<Ts...>& t) const {
+        return std::apply([](const auto&... fields) {
+            uint64_t h = 0x345678;
+            ((h = pyMixHash(h ^ PyHash<std::decay_t<decltype(fields)>>()(fields))), ...);
+            return h;
+        }, t);
+    }
+};
+
+template <>
+struct PyHash<double> {
+    uint64_t operator()(double d) const { return PyValue(d).hash(); }
+};
+
+template <>
+struct PyHash<bool> {
+    uint64_t operator()(bool b) const { return b ? 1 : 0; }
+};
+
+#endif // PYTUPLE_H
@@ -0,0 +1,398 @@
+#ifndef PYVALUE_H
+#define PYVALUE_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+
+#include "pyhash.h"
+#include "pyint.h"
+#include "pyobject.h"
+#include "pystr.h"
+
+// Dynamic value used by generated code wherever the type of a Python
+// expression is not known. Floats are stored as plain doubles; None, bools,
+// 48-bit ints and heap pointers live in the unused quiet-NaN space, so only
+// strings, ints outside the inline range and boxed containers need an
+// allocation. Int results that overflow are promoted to PyInt rather than
+// wrapping.
+
+struct PyBoxedInt : PyObject {
+    explicit PyBoxedInt(PyInt v) : value(std::move(v)) {}
+    void shareChildren() override { value.share(); }
+    PyInt value;
+};
+
+struct PyBoxedStr : PyObject {
+    explicit PyBoxedStr(PyStr v) : value(std::move(v)) {}
+    void shareChildren() override { value.share(); }
+    PyStr value;
+};
+
+class PyValue;
+class PyList;
+
+// A container held by a PyValue, e.g. a list passed where no type is
+// known. The container's own header implements it, so a PyValue can
+// print, measure and index one without depending on its layout.
+struct PyBoxedContainer : PyObject {
+    virtual std::size_t length() const = 0;
+    virtual PyValue item(std::size_t i) const = 0;
+    virtual std::string repr() const = 0;
+};
+
+class PyValue {
+public:
+    enum Tag { NONE, BOOL, INT, OBJECT };
+
+    static constexpr int64_t kMaxInline = (int64_t(1) << 47) - 1;
+    static constexpr int64_t kMinInline = -(int64_t(1) << 47);
+
+    PyValue() : bits(box(NONE, 0)) {}
+    PyValue(bool b) : bits(box(BOOL, b ? 1 : 0)) {}
+    PyValue(int i) : PyValue(int64_t(i)) {}
+    PyValue(int64_t i) : bits(boxInt(i)) {}
+    PyValue(PyInt i) : bits(i.isSmall() ? boxInt(i.toInt64()) : boxObject(new PyBoxedInt(std::move(i)))) {}
+    PyValue(double d) {
+        if (std::isnan(d)) {
+            bits = kCanonicalNaN;
+        } else {
+            std::memcpy(&bits, &d, sizeof bits);
+        }
+    }
+    PyValue(const char* s) : bits(boxObject(new PyBoxedStr(PyStr(s)))) {}
+    PyValue(const std::string& s) : bits(boxObject(new PyBoxedStr(PyStr(s)))) {}
+    PyValue(PyStr s) : bits(boxObject(new PyBoxedStr(std::move(s)))) {}
+    // Boxes a copy of the list; defined in pylist.h.
+    PyValue(const PyList& list);
+    // Defined in pytuple.h; boxes each field.
+    template <class... Ts>
+    PyValue(const std::tuple<Ts...>& tuple);
+
+    PyValue(const PyValue& other) : bits(other.bits) { retain(); }
+    PyValue(PyValue&& other) noexcept : bits(other.bits) { other.bits = box(NONE, 0); }
+    PyValue& operator=(PyValue other) noexcept {
+        std::swap(bits, other.bits);
+        return *this;
+    }
+    ~PyValue() { release(); }
+
+    bool isFloat() const { return (bits & kBoxMask) != kBoxMask; }
+    bool isNone() const { return bits == box(NONE, 0); }
+    bool isBool() const { return hasTag(BOOL); }
+    bool isSmallInt() const { return hasTag(INT); }
+    bool isObject() const { return hasTag(OBJECT); }
+    bool isInt() const { return isSmallInt() || dynamic_cast<PyBoxedInt*>(object()) != nullptr; }
+    bool isStr() const { return dynamic_cast<PyBoxedStr*>(object()) != nullptr; }
+    bool isContainer() const { return dynamic_cast<PyBoxedContainer*>(object()) != nullptr; }
+
+    bool asBool() const { return (bits & 1) != 0; }
+    double asFloat() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d;
+    }
+    int64_t asInt() const {
+        if (isSmallInt()) {
+            return int64_t(bits << 16) >> 16;
+        }
+        if (auto* boxed = dynamic_cast<PyBoxedInt*>(object())) {
+            return boxed->value.toInt64();
+        }
+        if (isBool()) {
+            return asBool() ? 1 : 0;
+        }
+        throw std::runtime_error("TypeError: value is not an int");
+    }
+    PyInt asPyInt() const {
+        if (auto* boxed = dynamic_cast<PyBoxedInt*>(object())) {
+            return boxed->value;
+        }
+        return PyInt(asInt());
+    }
+    const PyStr& asStr() const {
+        if (auto* boxed = dynamic_cast<PyBoxedStr*>(object())) {
+            return boxed->value;
+        }
+        throw std::runtime_error("TypeError: value is not a str");
+    }
+    const PyBoxedContainer& asContainer() const {
+        if (auto* boxed = dynamic_cast<PyBoxedContainer*>(object())) {
+            return *boxed;
+        }
+        throw std::runtime_error("TypeError: value is not a container");
+    }
+    PyObject* object() const {
+        return isObject() ? reinterpret_cast<PyObject*>(bits & kPayloadMask) : nullptr;
+    }
+    void share() const { pyShare(object()); }
+
+    bool truthy() const {
+        if (isFloat()) return asFloat() != 0.0;
+        if (isNone()) return false;
+        if (isBool()) return asBool();
+        if (isSmallInt()) return asInt() != 0;
+        if (isStr()) return !asStr().empty();
+        if (isContainer()) return asContainer().length() != 0;
+        return asPyInt() != PyInt(0);
+    }
+
+    // Walks a boxed container, so a list passed to an untyped parameter can
+    // be looped over or yielded from.
+    class iterator {
+    public:
+        iterator(const PyBoxedContainer* container, std::size_t i) : container(container), i(i) {}
+        PyValue operator*() const { return container->item(i); }
+        iterator& operator++() {
+            ++i;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return i == other.i; }
+        bool operator!=(const iterator& other) const { return i != other.i; }
+
+    private:
+        const PyBoxedContainer* container;
+        std::size_t i;
+    };
+    iterator begin() const { return iterator(&asContainer(), 0); }
+    iterator end() const { return iterator(&asContainer(), asContainer().length()); }
+
+    // Subscripts a boxed container, counting negative indexes from the end.
+    PyValue operator[](const PyValue& index) const {
+        const PyBoxedContainer& container = asContainer();
+        int64_t i = index.asInt();
+        int64_t n = int64_t(container.length());
+        if (i < 0) {
+            i += n;
+        }
+        if (i < 0 || i >= n) {
+            throw std::out_of_range("IndexError: list index out of range");
+        }
+        return container.item(std::size_t(i));
+    }
+
+    friend PyValue operator+(const PyValue& a, const PyValue& b) {
+        if (a.isSmallInt() && b.isSmallInt()) {
+            // Two 48-bit operands cannot overflow int64; the constructor
+            // re-boxes if the result leaves the inline range.
+            return PyValue(a.asInt() + b.asInt());
+        }
+        if (a.isStr() && b.isStr()) {
+            return PyValue(a.asStr() + b.asStr());
+        }
+        if (a.isNumericInt() && b.isNumericInt()) {
+            return PyValue(a.asPyInt() + b.asPyInt());
+        }
+        return PyValue(a.toDouble() + b.toDouble());
+    }
+    friend PyValue operator-(const PyValue& a, const PyValue& b) {
+        if (a.isSmallInt() && b.isSmallInt()) {
+            return PyValue(a.asInt() - b.asInt());
+        }
+        if (a.isNumericInt() && b.isNumericInt()) {
+            return PyValue(a.asPyInt() - b.asPyInt());
+        }
+        return PyValue(a.toDouble() - b.toDouble());
+    }
+    friend PyValue operator-(const PyValue& a) {
+        return a.isFloat() ? PyValue(-a.asFloat()) : PyValue(0) - a;
+    }
+    friend PyValue operator*(const PyValue& a, const PyValue& b) {
+        if (a.isNumericInt() && b.isNumericInt()) {
+            return PyValue(a.asPyInt() * b.asPyInt());
+        }
+        return PyValue(a.toDouble() * b.toDouble());
+    }
+    friend PyValue operator/(const PyValue& a, const PyValue& b) {
+        double divisor = b.toDouble();
+        if (divisor == 0.0) {
+            throw std::domain_error("ZeroDivisionError: division by zero");
+        }
+        return PyValue(a.toDouble() / divisor);
+    }
+    // Python's modulo: a nonzero result takes the divisor's sign.
+    friend PyValue operator%(const PyValue& a, const PyValue& b) {
+        if (a.isSmallInt() && b.isSmallInt() && b.asInt() != 0) {
+            int64_t r = a.asInt() % b.asInt();
+            return PyValue(r != 0 && (r < 0) != (b.asInt() < 0) ? r + b.asInt() : r);
+        }
+        if (a.isNumericInt() && b.isNumericInt()) {
+            return PyValue(a.asPyInt() % b.asPyInt());
+        }
+        double divisor = b.toDouble();
+        if (divisor == 0.0) {
+            throw std::domain_error("ZeroDivisionError: float modulo");
+        }
+        double r = std::fmod(a.toDouble(), divisor);
+        return PyValue(r != 0.0 && (r < 0) != (divisor < 0) ? r + divisor : r);
+    }
+
+    friend bool operator==(const PyValue& a, const PyValue& b) {
+        if (a.bits == b.bits) return !a.isFloat() || !std::isnan(a.asFloat());
+        if (a.isNumeric() && b.isNumeric()) {
+            if (a.isNumericInt() && b.isNumericInt()) return a.asPyInt() == b.asPyInt();
+            return a.toDouble() == b.toDouble();
+        }
+        if (a.isStr() && b.isStr()) return a.asStr() == b.asStr();
+        if (a.isContainer() && b.isContainer() && typeid(a.asContainer()) == typeid(b.asContainer())) {
+            const PyBoxedContainer& x = a.asContainer();
+            const PyBoxedContainer& y = b.asContainer();
+            bool equal = x.length() == y.length();
+            for (std::size_t i = 0; equal && i < x.length(); ++i) {
+                equal = x.item(i) == y.item(i);
+            }
+            return equal;
+        }
+        return false;
+    }
+    friend bool operator!=(const PyValue& a, const PyValue& b) { return !(a == b); }
+    friend bool operator<(const PyValue& a, const PyValue& b) { return less(a, b, "<"); }
+    friend bool operator>(const PyValue& a, const PyValue& b) { return less(b, a, ">"); }
+    // Spelled with == rather than as !(b < a), so a NaN compares false
+    // both ways as in Python.
+    friend bool operator<=(const PyValue& a, const PyValue& b) { return less(a, b, "<=") || a == b; }
+    friend bool operator>=(const PyValue& a, const PyValue& b) { return less(b, a, ">=") || a == b; }
+
+    // Equal numbers hash equally across int, float and bool, as in Python.
+    uint64_t hash() const {
+        // Memo and dict keys are mostly inline ints or strs; neither needs
+        // a PyInt or a second cast.
+        if (isSmallInt()) return uint64_t(asInt());
+        if (auto* boxed = dynamic_cast<PyBoxedStr*>(object())) return PyHash<std::string>()(boxed->value);
+        if (isNumericInt()) return asPyInt().hash();
+        if (isFloat()) {
+            double d = asFloat();
+            if (d == std::trunc(d) && !std::isinf(d)) return PyInt::fromDouble(d).hash();
+            return bits;
+        }
+        if (isContainer()) {
+            // Mixed like PyHash<std::tuple>, so contents that compare
+            // equal hash equally.
+            const PyBoxedContainer& c = asContainer();
+            uint64_t h = 0x345678;
+            for (std::size_t i = 0; i < c.length(); ++i) {
+                h = pyMixHash(h ^ c.item(i).hash());
+            }
+            return h;
+        }
+        return bits;
+    }
+
+    std::string str() const {
+        if (isNone()) return "None";
+        if (isBool()) return asBool() ? "True" : "False";
+        if (isStr()) return asStr().str();
+        if (isFloat()) return formatFloat(asFloat());
+        if (isContainer()) return asContainer().repr();
+        return asPyInt().str();
+    }
+    friend std::ostream& operator<<(std::ostream& os, const PyValue& v) {
+        return os << v.str();
+    }
+
+private:
+    static constexpr uint64_t kBoxMask = 0xFFF8000000000000ULL;
+    static constexpr uint64_t kPayloadMask = 0x0000FFFFFFFFFFFFULL;
+    static constexpr uint64_t kCanonicalNaN = 0x7FF8000000000000ULL;
+
+    static constexpr uint64_t box(Tag tag, uint64_t payload) {
+        return kBoxMask | (uint64_t(tag) << 48) | payload;
+    }
+    static uint64_t boxObject(PyObject* obj) {
+        return box(OBJECT, reinterpret_cast<uint64_t>(obj));
+    }
+    static uint64_t boxInt(int64_t i) {
+        if (i >= kMinInline && i <= kMaxInline) {
+            return box(INT, uint64_t(i) & kPayloadMask);
+        }
+        return boxObject(new PyBoxedInt(PyInt(i)));
+    }
+
+    bool hasTag(Tag tag) const {
+        return (bits & 0xFFFF000000000000ULL) == box(tag, 0);
+    }
+    bool isNumericInt() const {
+        return isSmallInt() || isBool() || dynamic_cast<PyBoxedInt*>(object()) != nullptr;
+    }
+    bool isNumeric() const { return isFloat() || isNumericInt(); }
+    double toDouble() const {
+        if (isFloat()) return asFloat();
+        if (isNumericInt()) return asPyInt().toDouble();
+        throw std::runtime_error("TypeError: unsupported operand type");
+    }
+    // a < b, the one ordering the relational operators are built from; op
+    // names the operator the program wrote for the TypeError.
+    static bool less(const PyValue& a, const PyValue& b, const char* op) {
+        // Sorting compares mostly inline ints or floats; skip the PyInt path.
+        if (a.isSmallInt() && b.isSmallInt()) return a.asInt() < b.asInt();
+        if (a.isFloat() && b.isFloat()) return a.asFloat() < b.asFloat();
+        if (a.isNumericInt() && b.isNumericInt()) return a.asPyInt() < b.asPyInt();
+        if (a.isNumeric() && b.isNumeric()) return a.toDouble() < b.toDouble();
+        if (a.isStr() && b.isStr()) return a.asStr() < b.asStr();
+        if (a.isContainer() && b.isContainer() && typeid(a.asContainer()) == typeid(b.asContainer())) {
+            // Lexicographic, as for Python sequences of the same type.
+            const PyBoxedContainer& x = a.asContainer();
+            const PyBoxedContainer& y = b.asContainer();
+            for (std::size_t i = 0; i < x.length() && i < y.length(); ++i) {
+                PyValue p = x.item(i);
+                PyValue q = y.item(i);
+                if (!(p == q)) {
+                    return less(p, q, op);
+                }
+            }
+            return x.length() < y.length();
+        }
+        throw std::runtime_error(std::string("TypeError: '") + op + "' not supported between these types");
+    }
+
+    static std::string formatFloat(double d) {
+        if (std::isnan(d)) return "nan";
+        if (std::isinf(d)) return d > 0 ? "inf" : "-inf";
+        char buf[32];
+        auto result = std::to_chars(buf, buf + sizeof buf, d);
+        std::string s(buf, result.ptr);
+        if (s.find_first_of(".e") == std::string::npos) {
+            s += ".0";
+        }
+        return s;
+    }
+
+    void retain() const {
+        if (PyObject* obj = object()) {
+            pyIncRef(obj);
+        }
+    }
+    void release() {
+        if (PyObject* obj = object()) {
+            pyDecRef(obj);
+        }
+    }
+
+    uint64_t bits;
+};
+
+template <>
+struct PyHash<PyValue> {
+    uint64_t operator()(const PyValue& v) const { return v.hash(); }
+};
+
+// len(). Containers report their size; a dynamic value only has one if it
+// holds a str or a boxed container.
+template <class T>
+PyValue pyLen(const T& container) {
+    return PyValue(int64_t(container.size()));
+}
+
+inline PyValue pyLen(const PyValue& v) {
+    return PyValue(int64_t(v.isContainer() ? v.asContainer().length() : v.asStr().size()));
+}
+
+static_assert(sizeof(PyValue) == sizeof(uint64_t), "PyValue must stay one machine word");
+
+#endif // PYVALUE_H
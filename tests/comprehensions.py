@@ -0,0 +1,25 @@
+def taxed(prices: list[float]):
+    cheap = [p for p in prices if p < 500.0]
+    return [c * 1.25 for c in cheap]
+
+
+def run():
+    xs = [1, 2, 3, 2]
+    ys = [x * 2 for x in xs]
+    zs = [y + 1 for y in ys]
+    print(zs)
+    bs = [x * 3 for x in xs]
+    a = [b - 1 for b in bs]
+    print(a)
+    d = {x: x * x for x in xs}
+    print(d)
+    names = {x: "v" for x in xs}
+    print(names)
+    e = {x: x for x in xs if x > 5}
+    print(e)
+    s = {x - x for x in xs}
+    print(s)
+    print(taxed([100.0, 600.0, 200.5]))
+
+
+run()
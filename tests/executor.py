@@ -0,0 +1,18 @@
+import concurrent.futures
+
+
+def twice(n):
+    return n * 2
+
+
+def run():
+    ex = concurrent.futures.ThreadPoolExecutor(max_workers=4)
+    future = ex.submit(twice, 5)
+    print(future.result())
+    ex.shutdown()
+    pool = concurrent.futures.ThreadPoolExecutor(2)
+    print(pool.submit(twice, 21).result())
+    pool.shutdown()
+
+
+run()
@@ -0,0 +1,16 @@
+def sq(x):
+    return x * x
+def run():
+    xs = [3, 1, 2]
+    ys = [10, 20, 30]
+    print(sum(map(sq, xs)))
+    print(any(filter(lambda v: v > 2, xs)))
+    print(sorted(zip(ys, xs)))
+    print(max(map(sq, xs)))
+    print(sum(xs))
+    print(max(xs))
+    print(sorted(map(sq, xs)))
+    print(all(map(lambda a, b: a < b, xs, ys)))
+    print(min(map(lambda a, b: a + b, xs, ys)))
+    print(sorted(filter(lambda v: v != 1, xs)))
+run()
@@ -0,0 +1,26 @@
+items = [3, 1, 2]
+rows = [[1, 2], [3, 4, 5]]
+
+
+def pick(i):
+    return len(rows[i % 2]) + items[i % 3]
+
+
+def shadow():
+    items = [9]
+    return len(items)
+
+
+def run():
+    total = 0
+    for i in range(10):
+        total += pick(i)
+    print(total)
+    print(len(items), shadow(), len(items))
+    items.append(7)
+    print(items[3], len(items), rows[1][2])
+    for x in items:
+        print(x)
+
+
+run()
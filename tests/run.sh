@@ -0,0 +1,43 @@
+#!/bin/sh
+# Translates each program given (default: every tests/*.py), compiles the
+# C++ and checks that it prints what CPython prints. A program defines
+# run() and ends by calling it; that last line is left out of the
+# translation and a C++ main() calls run() instead.
+# Usage: tests/run.sh [program.py...]
+set -u
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+CXX=${CXX:-g++}
+
+awk 'NR > 821' "$root/draft.cpp" | sed '/^```$/,$d' > "$work/py2cpp.cpp"
+"$CXX" -std=c++17 -O1 -pthread -I"$root" "$work/py2cpp.cpp" -o "$work/py2cpp" || exit 1
+
+[ $# -gt 0 ] || set -- "$root"/tests/*.py
+failed=0
+for program in "$@"; do
+    name=$(basename "$program" .py)
+    head -n -1 "$program" > "$work/$name.py"
+    if ! "$work/py2cpp" "$work/$name.py" -o "$work/$name.cpp"; then
+        echo "FAIL $name: translation"
+        failed=1
+        continue
+    fi
+    echo 'int main() { run(); }' >> "$work/$name.cpp"
+    if ! "$CXX" -std=c++20 -O1 -pthread -I"$root" "$work/$name.cpp" -o "$work/$name" 2> "$work/$name.err"; then
+        echo "FAIL $name: compilation"
+        head -n 20 "$work/$name.err"
+        failed=1
+        continue
+    fi
+    "$work/$name" > "$work/$name.out"
+    python3 "$program" > "$work/$name.expected"
+    if cmp -s "$work/$name.out" "$work/$name.expected"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name: output"
+        diff "$work/$name.out" "$work/$name.expected"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,17 @@
+def neg(v):
+    return -v
+
+
+def run():
+    xs = [3, 1, 2]
+    print(sorted(xs, key=lambda v: -v))
+    print(sorted(xs, key=neg, reverse=True))
+    words = ["bb", "a", "ccc"]
+    print(sorted(words, key=len))
+    pairs = [(2, "b"), (1, "z"), (3, "a")]
+    print(sorted(pairs, key=lambda p: p[1]))
+    xs.sort(key=lambda v: v % 3)
+    print(xs)
+
+
+run()
@@ -0,0 +1,29 @@
+import concurrent.futures
+import threading
+
+rows = [[1, 2], [3, 4, 5], [6], [7, 8]]
+
+
+def scan(n):
+    total = 0
+    for i in range(n):
+        total += len(rows[i % 4])
+    return total
+
+
+def run():
+    first = threading.Thread(target=scan, args=(20000,))
+    second = threading.Thread(target=scan, args=(20000,))
+    first.start()
+    second.start()
+    first.join()
+    second.join()
+    pool = concurrent.futures.ThreadPoolExecutor(max_workers=4)
+    a = pool.submit(scan, 20001)
+    b = pool.submit(scan, 20002)
+    print(a.result())
+    print(b.result())
+    pool.shutdown()
+
+
+run()
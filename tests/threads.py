@@ -0,0 +1,17 @@
+import threading
+
+
+def show(a, b):
+    print(a + b)
+
+
+def run():
+    first = threading.Thread(target=show, args=(3, 4))
+    first.start()
+    first.join()
+    second = threading.Thread(target=show, args=("a", "b",))
+    second.start()
+    second.join()
+
+
+run()
@@ -0,0 +1,17 @@
+import functools
+@functools.lru_cache(maxsize=None)
+def first(pair):
+    return pair[0]
+def run():
+    a = 1
+    b = 2
+    seen = set()
+    seen.add((a, b))
+    seen.add((a, b))
+    print(len(seen))
+    s = {(a, b), (1, 2), (2, 1)}
+    print(len(s))
+    print(first((a, b)))
+    print(first((1, 2)))
+    print(first.cache_info())
+run()